@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include "structures/concurrent_dense_map.hpp"
+#include "structures/dense_map.hpp"
+
+using namespace atom::utils;
+
+constexpr uint32_t key_count = 1U << 16U;
+
+static dense_map<uint32_t, uint64_t>& locked_map() {
+    static dense_map<uint32_t, uint64_t> map = [] {
+        dense_map<uint32_t, uint64_t> map;
+        for (uint32_t i = 0; i < key_count; ++i) {
+            map.emplace(i, uint64_t{ i });
+        }
+        return map;
+    }();
+    return map;
+}
+
+static concurrent_dense_map<uint32_t, uint64_t>& lock_free_map() {
+    static concurrent_dense_map<uint32_t, uint64_t> map;
+    static const bool filled = [] {
+        for (uint32_t i = 0; i < key_count; ++i) {
+            map.emplace(i, uint64_t{ i });
+        }
+        return true;
+    }();
+    (void)filled;
+    return map;
+}
+
+static void BM_DenseMap_SharedMutexRead(benchmark::State& state) {
+    auto& map    = locked_map();
+    uint32_t key = static_cast<uint32_t>(state.thread_index()) * 7919U;
+    uint64_t sum = 0;
+    for (auto _ : state) {
+        sum += map.at(key++ & (key_count - 1));
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DenseMap_SharedMutexRead)->ThreadRange(1, 32)->UseRealTime();
+
+static void BM_ConcurrentDenseMap_Read(benchmark::State& state) {
+    auto& map    = lock_free_map();
+    uint32_t key = static_cast<uint32_t>(state.thread_index()) * 7919U;
+    uint64_t sum = 0;
+    for (auto _ : state) {
+        sum += *map.get(key++ & (key_count - 1));
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentDenseMap_Read)->ThreadRange(1, 32)->UseRealTime();
+
+static void BM_ConcurrentDenseMap_ReadWithWriter(benchmark::State& state) {
+    auto& map    = lock_free_map();
+    uint32_t key = static_cast<uint32_t>(state.thread_index()) * 7919U;
+    uint64_t sum = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            const auto slot = key & (key_count - 1);
+            map.insert_or_assign(slot, uint64_t{ key });
+            ++key;
+        }
+        else {
+            sum += map.get(key++ & (key_count - 1)).value_or(0);
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentDenseMap_ReadWithWriter)->ThreadRange(2, 32)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <benchmark/benchmark.h>
+#include "memory/allocator.hpp"
+#include "memory/pool.hpp"
+#include "thread/coroutine.hpp"
+
+using namespace atom::utils;
+
+static std::atomic<std::size_t> allocations;
+
+void* operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* const ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* const ptr, std::size_t) noexcept { std::free(ptr); }
+
+static auto counter() -> thread_safe_coroutine<int> {
+    auto value = 0;
+    while (true) {
+        co_yield value++;
+    }
+}
+
+static std::optional<thread_safe_coroutine<int>> shared_counter;
+
+// Every thread resumes the same coroutine, each resume waits for the one running elsewhere.
+static void BM_ThreadSafeCoroutine_Resume(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared_counter.emplace(counter());
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_counter->get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ThreadSafeCoroutine_Resume)->Threads(1)->Threads(2)->Threads(4)->UseRealTime();
+
+static auto digits(int value) -> coroutine<int> {
+    while (true) {
+        co_yield value % 10;
+        value /= 10;
+    }
+}
+
+template <typename Alloc>
+static auto digits(std::allocator_arg_t, const Alloc&, int value) -> coroutine<int> {
+    while (true) {
+        co_yield value % 10;
+        value /= 10;
+    }
+}
+
+// A short-lived generator per item, only its first values are taken.
+static void BM_Generator_Create(benchmark::State& state) {
+    const auto before = allocations.load(std::memory_order_relaxed);
+    auto value        = 0;
+    for (auto _ : state) {
+        auto generator = digits(++value);
+        benchmark::DoNotOptimize(generator.get() + generator.get());
+    }
+    const auto count             = allocations.load(std::memory_order_relaxed) - before;
+    state.counters["allocs/gen"] =
+        static_cast<double>(count) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_Generator_Create);
+
+// The same, with frames from a pool passed after std::allocator_arg.
+static void BM_Generator_CreateFromPool(benchmark::State& state) {
+    unsynchronized_pool pool;
+    const allocator<std::byte, unsynchronized_pool> alloc{ pool };
+    const auto before = allocations.load(std::memory_order_relaxed);
+    auto value        = 0;
+    for (auto _ : state) {
+        auto generator = digits(std::allocator_arg, alloc, ++value);
+        benchmark::DoNotOptimize(generator.get() + generator.get());
+    }
+    const auto count             = allocations.load(std::memory_order_relaxed) - before;
+    state.counters["allocs/gen"] =
+        static_cast<double>(count) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_Generator_CreateFromPool);
+
+BENCHMARK_MAIN();
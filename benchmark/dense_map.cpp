@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "structures/dense_map.hpp"
+#include "structures/dense_set.hpp"
+#include "structures/join_view.hpp"
+#include "structures/soa_dense_map.hpp"
+#include "thread/lock.hpp"
+
+using namespace atom::utils;
+
+struct component {
+    float position[3];
+    float velocity[3];
+    float padding[10];
+};
+
+template <typename Val>
+using unsync_dense_map = dense_map<uint32_t, Val, std::allocator<std::pair<uint32_t, Val>>,
+                                   k_default_page_size, null_lock>;
+
+template <typename Val>
+using unsync_soa_dense_map = soa_dense_map<uint32_t, Val, std::allocator<std::pair<uint32_t, Val>>,
+                                           k_default_page_size, null_lock>;
+
+static void BM_DenseMap_IterateValues(benchmark::State& state) {
+    unsync_dense_map<component> map;
+    for (uint32_t i = 0; i < state.range(0); ++i) {
+        map.emplace(i, component{});
+    }
+    for (auto _ : state) {
+        for (auto& [key, value] : map) {
+            value.position[0] += value.velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_IterateValues)->Range(1 << 10, 1 << 20);
+
+static void BM_SoaDenseMap_IterateValues(benchmark::State& state) {
+    unsync_soa_dense_map<component> map;
+    for (uint32_t i = 0; i < state.range(0); ++i) {
+        map.emplace(i, component{});
+    }
+    for (auto _ : state) {
+        for (auto& value : map.values()) {
+            value.position[0] += value.velocity[0];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SoaDenseMap_IterateValues)->Range(1 << 10, 1 << 20);
+
+static void BM_DenseMap_ScaleFloats(benchmark::State& state) {
+    unsync_dense_map<float> map;
+    for (uint32_t i = 0; i < state.range(0); ++i) {
+        map.emplace(i, static_cast<float>(i));
+    }
+    for (auto _ : state) {
+        for (auto& [key, value] : map) {
+            value *= 1.0001F;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_ScaleFloats)->Range(1 << 10, 1 << 20);
+
+static void BM_SoaDenseMap_ScaleFloats(benchmark::State& state) {
+    unsync_soa_dense_map<float> map;
+    for (uint32_t i = 0; i < state.range(0); ++i) {
+        map.emplace(i, static_cast<float>(i));
+    }
+    for (auto _ : state) {
+        for (auto& value : map.values()) {
+            value *= 1.0001F;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SoaDenseMap_ScaleFloats)->Range(1 << 10, 1 << 20);
+
+static auto shuffled_keys(const int64_t count) {
+    std::vector<uint32_t> keys(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        keys[i] = i * 3;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{ 42 });
+    return keys;
+}
+
+static auto shuffled_pairs(const int64_t count) {
+    std::vector<std::pair<uint32_t, uint64_t>> pairs;
+    pairs.reserve(count);
+    for (auto key : shuffled_keys(count)) {
+        pairs.emplace_back(key, key);
+    }
+    return pairs;
+}
+
+static void BM_DenseMap_EmplaceLoop(benchmark::State& state) {
+    const auto pairs = shuffled_pairs(state.range(0));
+    for (auto _ : state) {
+        dense_map<uint32_t, uint64_t> map;
+        for (const auto& [key, value] : pairs) {
+            map.emplace(key, value);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_EmplaceLoop)->Range(1 << 10, 1 << 17);
+
+static void BM_DenseMap_InsertRange(benchmark::State& state) {
+    const auto pairs = shuffled_pairs(state.range(0));
+    for (auto _ : state) {
+        dense_map<uint32_t, uint64_t> map;
+        map.insert_range(pairs);
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_InsertRange)->Range(1 << 10, 1 << 17);
+
+// the same pairs, inserted 16 at a time.
+static void BM_DenseMap_InsertRangeBatches(benchmark::State& state) {
+    constexpr std::size_t batch = 16;
+    const auto pairs            = shuffled_pairs(state.range(0));
+    for (auto _ : state) {
+        dense_map<uint32_t, uint64_t> map;
+        for (std::size_t first = 0; first < pairs.size(); first += batch) {
+            const auto count = std::min(batch, pairs.size() - first);
+            map.insert_range(std::span{ pairs }.subspan(first, count));
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_InsertRangeBatches)->Range(1 << 10, 1 << 17);
+
+template <typename Map>
+static void find_loop(benchmark::State& state) {
+    Map map;
+    map.insert_range(shuffled_pairs(state.range(0)));
+    const auto keys = shuffled_keys(state.range(0));
+    std::vector<typename Map::iterator> out(keys.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            out[i] = map.find(keys[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_DenseMap_FindLoop(benchmark::State& state) {
+    find_loop<dense_map<uint32_t, uint64_t>>(state);
+}
+BENCHMARK(BM_DenseMap_FindLoop)->Range(1 << 10, 1 << 20);
+
+// without a lock, so the page lookup is most of the cost.
+template <bool InlinePages>
+using unlocked_map = dense_map<
+    uint32_t, uint64_t, std::allocator<std::pair<uint32_t, uint64_t>>, k_default_page_size,
+    null_lock, 0, InlinePages>;
+
+static void BM_DenseMap_FindLoop_HeapPages(benchmark::State& state) {
+    find_loop<unlocked_map<false>>(state);
+}
+BENCHMARK(BM_DenseMap_FindLoop_HeapPages)->Range(1 << 10, 1 << 20);
+
+static void BM_DenseMap_FindLoop_InlinePages(benchmark::State& state) {
+    find_loop<unlocked_map<true>>(state);
+}
+BENCHMARK(BM_DenseMap_FindLoop_InlinePages)->Range(1 << 10, 1 << 20);
+
+static std::size_t allocated_bytes;
+
+template <typename Ty>
+struct counting_allocator : std::allocator<Ty> {
+    using value_type = Ty;
+
+    counting_allocator() = default;
+    template <typename Other>
+    counting_allocator(const counting_allocator<Other>&) noexcept {}
+
+    auto allocate(const std::size_t count) -> Ty* {
+        allocated_bytes += count * sizeof(Ty);
+        return std::allocator<Ty>::allocate(count);
+    }
+};
+
+// A single large key. Heap pages leave every entry below it empty, inline pages pay a whole page
+// for each: about 12 MiB against 88 MiB of RSS for a key of 10'000'000, so inline pages only suit
+// keys that are dense from zero.
+template <bool InlinePages>
+static void sparse_key(benchmark::State& state) {
+    using map_t = dense_map<
+        uint32_t, uint64_t, counting_allocator<std::pair<uint32_t, uint64_t>>, k_default_page_size,
+        null_lock, 0, InlinePages>;
+    std::size_t bytes{};
+    for (auto _ : state) {
+        allocated_bytes = 0;
+        map_t map;
+        map.emplace(static_cast<uint32_t>(state.range(0)), 0);
+        bytes = allocated_bytes;
+        benchmark::DoNotOptimize(map);
+    }
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+static void BM_DenseMap_SparseKey_HeapPages(benchmark::State& state) { sparse_key<false>(state); }
+BENCHMARK(BM_DenseMap_SparseKey_HeapPages)->Arg(10'000'000);
+
+static void BM_DenseMap_SparseKey_InlinePages(benchmark::State& state) { sparse_key<true>(state); }
+BENCHMARK(BM_DenseMap_SparseKey_InlinePages)->Arg(10'000'000);
+
+static void BM_DenseMap_FindMany(benchmark::State& state) {
+    dense_map<uint32_t, uint64_t> map;
+    map.insert_range(shuffled_pairs(state.range(0)));
+    const auto keys = shuffled_keys(state.range(0));
+    std::vector<decltype(map)::iterator> out(keys.size());
+    for (auto _ : state) {
+        map.find_many(keys, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_FindMany)->Range(1 << 10, 1 << 20);
+
+static void BM_DenseMap_EraseLoop(benchmark::State& state) {
+    const auto pairs = shuffled_pairs(state.range(0));
+    const auto keys  = shuffled_keys(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        dense_map<uint32_t, uint64_t> map;
+        map.insert_range(pairs);
+        state.ResumeTiming();
+        for (const auto key : keys) {
+            map.erase(key);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_EraseLoop)->Range(1 << 10, 1 << 17);
+
+static void BM_DenseMap_EraseRange(benchmark::State& state) {
+    const auto pairs = shuffled_pairs(state.range(0));
+    const auto keys  = shuffled_keys(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        dense_map<uint32_t, uint64_t> map;
+        map.insert_range(pairs);
+        state.ResumeTiming();
+        map.erase_range(keys);
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_EraseRange)->Range(1 << 10, 1 << 17);
+
+struct join_fixture {
+    explicit join_fixture(const uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            positions.emplace(i, component{});
+            if (i % 2 == 0) {
+                speeds.emplace(i, 1.F);
+            }
+            if (i % 3 == 0) {
+                alive.emplace(i);
+            }
+        }
+    }
+
+    dense_map<uint32_t, component> positions;
+    dense_map<uint32_t, float> speeds;
+    dense_set<uint32_t> alive;
+};
+
+static void BM_DenseMap_JoinByFind(benchmark::State& state) {
+    join_fixture fixture(static_cast<uint32_t>(state.range(0)));
+    for (auto _ : state) {
+        for (auto& [key, position] : fixture.positions) {
+            auto speed = fixture.speeds.find(key);
+            if (speed != fixture.speeds.end() && fixture.alive.contains(key)) {
+                position.position[0] += speed->second;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_JoinByFind)->Range(1 << 10, 1 << 20);
+
+static void BM_DenseMap_JoinView(benchmark::State& state) {
+    join_fixture fixture(static_cast<uint32_t>(state.range(0)));
+    auto view = join(fixture.positions, fixture.speeds, fixture.alive);
+    for (auto _ : state) {
+        view.each([](uint32_t, component& position, float& speed) {
+            position.position[0] += speed;
+        });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_JoinView)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
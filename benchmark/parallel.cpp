@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "structures/dense_map.hpp"
+#include "thread/parallel.hpp"
+#include "thread/thread_pool.hpp"
+
+using namespace atom::utils;
+
+struct particle {
+    float position[3];
+    float velocity[3];
+};
+
+static void update(particle& particle) {
+    for (auto i = 0; i < 3; ++i) {
+        particle.velocity[i] = std::sin(particle.velocity[i]) * 0.99F;
+        particle.position[i] += particle.velocity[i];
+    }
+}
+
+static auto make_particles(const int64_t count) {
+    dense_map<uint32_t, particle> map;
+    for (uint32_t i = 0; i < count; ++i) {
+        map.emplace(i, particle{ { 0.F, 0.F, 0.F }, { 1.F, 1.F, 1.F } });
+    }
+    return map;
+}
+
+static void BM_DenseMap_SerialUpdate(benchmark::State& state) {
+    auto map = make_particles(state.range(0));
+    for (auto _ : state) {
+        for (auto& [key, particle] : map) {
+            update(particle);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_SerialUpdate)->Arg(1 << 20)->Arg(1 << 22)->UseRealTime();
+
+static void BM_DenseMap_ParallelUpdate(benchmark::State& state) {
+    auto map = make_particles(state.range(0));
+    thread_pool pool(static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state) {
+        parallel_for_each(map, [](auto& pair) { update(pair.second); }, pool);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DenseMap_ParallelUpdate)
+    ->ArgsProduct({ { 1 << 20, 1 << 22 }, { 1, 2, 4, 8 } })
+    ->UseRealTime();
+
+// Inputs from 1M to 100M elements, the parallel versions with 1 to 8 workers.
+static void large_inputs(benchmark::internal::Benchmark* bench) {
+    for (const auto count : { 1 << 20, 10 << 20, 100 << 20 }) {
+        bench->Args({ count, 0 });
+        for (const auto threads : { 1, 2, 4, 8 }) {
+            bench->Args({ count, threads });
+        }
+    }
+}
+
+static auto random_keys(const int64_t count) {
+    std::vector<uint32_t> keys(static_cast<std::size_t>(count));
+    uint32_t state = 1;
+    for (auto& key : keys) {
+        state = state * 1664525U + 1013904223U;
+        key   = state;
+    }
+    return keys;
+}
+
+// the second argument is the number of workers, 0 runs the standard serial algorithm.
+static void BM_Reduce(benchmark::State& state) {
+    std::vector<uint64_t> values(static_cast<std::size_t>(state.range(0)), 3);
+    thread_pool pool(static_cast<std::size_t>(std::max<int64_t>(state.range(1), 1)));
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            benchmark::DoNotOptimize(std::reduce(values.begin(), values.end(), uint64_t{}));
+        }
+        else {
+            benchmark::DoNotOptimize(parallel_reduce(values, uint64_t{}, std::plus<>{}, pool));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Reduce)->Apply(large_inputs)->UseRealTime();
+
+static void BM_InclusiveScan(benchmark::State& state) {
+    std::vector<uint64_t> values(static_cast<std::size_t>(state.range(0)), 3);
+    std::vector<uint64_t> output(values.size());
+    thread_pool pool(static_cast<std::size_t>(std::max<int64_t>(state.range(1), 1)));
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            std::inclusive_scan(values.begin(), values.end(), output.begin());
+        }
+        else {
+            parallel_inclusive_scan(values, output.begin(), std::plus<>{}, pool);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_InclusiveScan)->Apply(large_inputs)->UseRealTime();
+
+static void BM_Sort(benchmark::State& state) {
+    const auto keys = random_keys(state.range(0));
+    thread_pool pool(static_cast<std::size_t>(std::max<int64_t>(state.range(1), 1)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto copy = keys;
+        state.ResumeTiming();
+        if (state.range(1) == 0) {
+            std::ranges::sort(copy);
+        }
+        else {
+            parallel_sort(copy, pool);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sort)->Apply(large_inputs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Iterations whose cost grows with the index, where one block for each thread is unbalanced.
+static void skewed_work(const int index, std::vector<float>& output) {
+    auto value = static_cast<float>(index);
+    for (auto i = 0; i < index >> 14; ++i) {
+        value = std::sin(value);
+    }
+    output[static_cast<std::size_t>(index)] = value;
+}
+
+static void parallel_for_skewed(benchmark::State& state, const partitioning mode) {
+    const auto count = static_cast<int>(state.range(0));
+    std::vector<float> output(static_cast<std::size_t>(count));
+    thread_pool pool(static_cast<std::size_t>(state.range(1)));
+    for (auto _ : state) {
+        parallel_for(
+            0, count, [&output](const int index) { skewed_work(index, output); }, pool,
+            k_default_parallel_grain, mode);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ParallelFor_Static(benchmark::State& state) {
+    parallel_for_skewed(state, partitioning::static_split);
+}
+BENCHMARK(BM_ParallelFor_Static)->ArgsProduct({ { 1 << 20 }, { 1, 2, 4, 8 } })->UseRealTime();
+
+static void BM_ParallelFor_Dynamic(benchmark::State& state) {
+    parallel_for_skewed(state, partitioning::dynamic);
+}
+BENCHMARK(BM_ParallelFor_Dynamic)->ArgsProduct({ { 1 << 20 }, { 1, 2, 4, 8 } })->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,221 @@
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <list>
+#include <set>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "memory/allocator.hpp"
+#include "memory/pool.hpp"
+#include "structures/dense_map.hpp"
+#include "structures/linear.hpp"
+#include "structures/set.hpp"
+
+using namespace atom::utils;
+
+template <typename List>
+static void list_churn(benchmark::State& state, List& list) {
+    const auto count = state.range(0);
+    for (auto _ : state) {
+        for (auto i = 0; i < count; ++i) {
+            list.push_back(i);
+        }
+        // erase every other node, then refill the holes, then drop everything
+        for (auto iter = list.begin(); iter != list.end();) {
+            iter = list.erase(iter);
+            if (iter != list.end()) {
+                ++iter;
+            }
+        }
+        for (auto i = 0; i < count / 2; ++i) {
+            list.push_front(i);
+        }
+        list.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+
+template <typename Deque>
+static void deque_churn(benchmark::State& state, Deque& deque) {
+    const auto count = state.range(0);
+    for (auto _ : state) {
+        for (auto i = 0; i < count; ++i) {
+            deque.push_back(i);
+        }
+        for (auto i = 0; i < count; ++i) {
+            deque.push_back(i);
+            deque.pop_front();
+        }
+        deque.clear();
+        deque.shrink_to_fit();
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+
+static void BM_StdList_Churn(benchmark::State& state) {
+    std::list<int> list;
+    list_churn(state, list);
+}
+BENCHMARK(BM_StdList_Churn)->Range(1 << 8, 1 << 16);
+
+static void BM_UnsyncList_Churn(benchmark::State& state) {
+    unsynchronized_pool pool;
+    std::list<int, unsync_allocator<int>> list{ unsync_allocator<int>{ pool } };
+    list_churn(state, list);
+}
+BENCHMARK(BM_UnsyncList_Churn)->Range(1 << 8, 1 << 16);
+
+static void BM_NodeList_Churn(benchmark::State& state) {
+    object_pool<int> pool;
+    unsync_list<int> list{ unsync_node_allocator<int>{ pool } };
+    list_churn(state, list);
+}
+BENCHMARK(BM_NodeList_Churn)->Range(1 << 8, 1 << 16);
+
+template <typename Set>
+static void set_churn(benchmark::State& state, Set& set) {
+    const auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        for (auto i = 0; i < count; ++i) {
+            set.insert(i * 7 % count);
+        }
+        for (auto i = 0; i < count; i += 2) {
+            set.erase(i);
+        }
+        set.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_StdSet_Churn(benchmark::State& state) {
+    std::set<int> set;
+    set_churn(state, set);
+}
+BENCHMARK(BM_StdSet_Churn)->Range(1 << 8, 1 << 16);
+
+static void BM_NodeSet_Churn(benchmark::State& state) {
+    object_pool<int> pool;
+    unsync_set<int> set{ std::less<int>{}, unsync_node_allocator<int>{ pool } };
+    set_churn(state, set);
+}
+BENCHMARK(BM_NodeSet_Churn)->Range(1 << 8, 1 << 16);
+
+static void BM_StdDeque_Churn(benchmark::State& state) {
+    std::deque<int> deque;
+    deque_churn(state, deque);
+}
+BENCHMARK(BM_StdDeque_Churn)->Range(1 << 8, 1 << 16);
+
+static void BM_UnsyncDeque_Churn(benchmark::State& state) {
+    unsynchronized_pool pool;
+    unsync_deque<int> deque{ unsync_allocator<int>{ pool } };
+    deque_churn(state, deque);
+}
+BENCHMARK(BM_UnsyncDeque_Churn)->Range(1 << 8, 1 << 16);
+
+// Each thread keeps a window of live blocks of mixed sizes and replaces them one after another.
+constexpr std::size_t k_window = 1024;
+
+template <typename Alloc, typename Free>
+static void threaded_churn(benchmark::State& state, Alloc alloc, Free free) {
+    std::vector<std::pair<void*, std::size_t>> window(k_window);
+    std::size_t size = 16;
+    for (auto& [ptr, bytes] : window) {
+        bytes = size;
+        ptr   = alloc(bytes);
+        size  = size % 512 + 16;
+    }
+    for (auto _ : state) {
+        for (auto& [ptr, bytes] : window) {
+            free(ptr, bytes);
+            ptr = alloc(bytes);
+            benchmark::DoNotOptimize(ptr);
+        }
+    }
+    for (auto& [ptr, bytes] : window) {
+        free(ptr, bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * k_window);
+}
+
+static void BM_Malloc_Threaded(benchmark::State& state) {
+    threaded_churn(
+        state, [](const std::size_t bytes) { return std::malloc(bytes); },
+        [](void* ptr, std::size_t) { std::free(ptr); });
+}
+BENCHMARK(BM_Malloc_Threaded)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+static synchronized_pool shared_pool;
+
+static void BM_SyncPool_Threaded(benchmark::State& state) {
+    threaded_churn(
+        state,
+        [](const std::size_t bytes) {
+            return static_cast<void*>(shared_pool.allocate<char>(bytes));
+        },
+        [](void* ptr, const std::size_t bytes) {
+            shared_pool.deallocate(static_cast<char*>(ptr), bytes);
+        });
+}
+BENCHMARK(BM_SyncPool_Threaded)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+// Random reads over a large array, where most of the cost is TLB misses on 4 KiB pages.
+static void random_reads(benchmark::State& state, const pool_backing backing) {
+    unsynchronized_pool pool{ backing };
+    const auto count = static_cast<std::size_t>(state.range(0)) / sizeof(std::uint64_t);
+    auto* const data = pool.get()->allocate<std::uint64_t>(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        data[i] = i;
+    }
+    std::uint64_t index = 1;
+    std::uint64_t sum   = 0;
+    for (auto _ : state) {
+        for (auto i = 0; i < 1024; ++i) {
+            index = index * 6364136223846793005ULL + 1442695040888963407ULL;
+            sum += data[(index >> 16) % count];
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    pool.get()->deallocate(data, count);
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+static void BM_RandomReads_SmallPages(benchmark::State& state) { random_reads(state, {}); }
+BENCHMARK(BM_RandomReads_SmallPages)->Arg(64 << 20)->Arg(512 << 20);
+
+static void BM_RandomReads_HugePages(benchmark::State& state) {
+    random_reads(state, { .huge_pages = true, .numa_local = true });
+}
+BENCHMARK(BM_RandomReads_HugePages)->Arg(64 << 20)->Arg(512 << 20);
+
+static void dense_map_lookups(benchmark::State& state, const pool_backing backing) {
+    using alloc_t = unsync_allocator<std::pair<std::uint32_t, std::uint64_t>>;
+    unsynchronized_pool pool{ backing };
+    dense_map<std::uint32_t, std::uint64_t, alloc_t> map{ alloc_t{ pool } };
+    const auto count = static_cast<std::uint32_t>(state.range(0));
+    for (std::uint32_t i = 0; i < count; ++i) {
+        map.emplace(i * 3, i);
+    }
+    std::uint64_t index = 1;
+    std::uint64_t sum   = 0;
+    for (auto _ : state) {
+        for (auto i = 0; i < 1024; ++i) {
+            index = index * 6364136223846793005ULL + 1442695040888963407ULL;
+            sum += map.at(static_cast<std::uint32_t>((index >> 16) % count) * 3);
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+static void BM_DenseMapLookup_SmallPages(benchmark::State& state) {
+    dense_map_lookups(state, {});
+}
+BENCHMARK(BM_DenseMapLookup_SmallPages)->Arg(1 << 22);
+
+static void BM_DenseMapLookup_HugePages(benchmark::State& state) {
+    dense_map_lookups(state, { .huge_pages = true, .numa_local = true });
+}
+BENCHMARK(BM_DenseMapLookup_HugePages)->Arg(1 << 22);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,53 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "memory/storage.hpp"
+
+using namespace atom::utils;
+
+template <typename RefCount>
+using storage_t = shared_storage<std::uint64_t, std::allocator<std::uint64_t>, RefCount>;
+
+// Copies a storage into a vector and drops the copies, one increment and one decrement each.
+template <typename RefCount>
+static void copy_and_drop(benchmark::State& state) {
+    const storage_t<RefCount> storage{ std::uint64_t{ 42 } };
+    std::vector<storage_t<RefCount>> copies;
+    copies.reserve(1024);
+    for (auto _ : state) {
+        for (auto i = 0; i < 1024; ++i) {
+            copies.emplace_back(storage);
+        }
+        copies.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+static void BM_SharedStorage_Copy_Atomic(benchmark::State& state) {
+    copy_and_drop<atomic_refcount>(state);
+}
+BENCHMARK(BM_SharedStorage_Copy_Atomic);
+
+static void BM_SharedStorage_Copy_Plain(benchmark::State& state) {
+    copy_and_drop<plain_refcount>(state);
+}
+BENCHMARK(BM_SharedStorage_Copy_Plain);
+
+static void BM_SharedStorage_Make(benchmark::State& state) {
+    for (auto _ : state) {
+        storage_t<plain_refcount> storage{ std::uint64_t{ 42 } };
+        benchmark::DoNotOptimize(storage.get());
+    }
+}
+BENCHMARK(BM_SharedStorage_Make);
+
+static void BM_SharedStorage_Adopt(benchmark::State& state) {
+    for (auto _ : state) {
+        storage_t<plain_refcount> storage{ new std::uint64_t{ 42 } };
+        benchmark::DoNotOptimize(storage.get());
+    }
+}
+BENCHMARK(BM_SharedStorage_Adopt);
+
+BENCHMARK_MAIN();
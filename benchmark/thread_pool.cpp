@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "thread/coroutine.hpp"
+#include "thread/task_graph.hpp"
+#include "thread/thread_pool.hpp"
+
+using namespace atom::utils;
+
+static std::atomic<std::int64_t> allocations;
+
+// NOLINTBEGIN(cppcoreguidelines-no-malloc)
+void* operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* const ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+// NOLINTEND(cppcoreguidelines-no-malloc)
+
+// Binary fork/join tree: every task forks one child onto the pool and continues with the other
+// itself, leaves count down and the last one wakes the caller. Tasks do almost no work, so the
+// cost measured is the scheduling itself.
+static void fork_tree(thread_pool& pool, std::atomic<std::int64_t>& pending, const int depth) {
+    for (auto level = depth; level != 0; --level) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        pool.enqueue(fork_tree, std::ref(pool), std::ref(pending), level - 1);
+    }
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pending.notify_one();
+    }
+}
+
+static void fork_join(benchmark::State& state, const scheduling mode) {
+    thread_pool pool(static_cast<std::size_t>(state.range(1)), mode);
+    const auto depth = static_cast<int>(state.range(0));
+    std::atomic<std::int64_t> pending;
+    for (auto _ : state) {
+        pending.store(1, std::memory_order_relaxed);
+        pool.enqueue(fork_tree, std::ref(pool), std::ref(pending), depth);
+        for (auto left = pending.load(); left != 0; left = pending.load()) {
+            pending.wait(left);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (std::int64_t{ 1 } << depth));
+}
+
+static void BM_ForkJoin_SharedQueue(benchmark::State& state) {
+    fork_join(state, scheduling::shared_queue);
+}
+BENCHMARK(BM_ForkJoin_SharedQueue)->ArgsProduct({ { 14 }, { 1, 2, 4, 8, 16 } })->UseRealTime();
+
+static void BM_ForkJoin_WorkStealing(benchmark::State& state) {
+    fork_join(state, scheduling::work_stealing);
+}
+BENCHMARK(BM_ForkJoin_WorkStealing)->ArgsProduct({ { 14 }, { 1, 2, 4, 8, 16 } })->UseRealTime();
+
+// Submission alone: the caller submits empty tasks as fast as it can, then waits for them all.
+template <typename Submit>
+static void submissions(benchmark::State& state, const scheduling mode, Submit submit) {
+    thread_pool pool(2, mode);
+    constexpr auto count = 1024;
+    std::atomic<std::int64_t> pending;
+    std::int64_t allocated{};
+    for (auto _ : state) {
+        pending.store(count, std::memory_order_relaxed);
+        const auto before = allocations.load(std::memory_order_relaxed);
+        for (auto i = 0; i < count; ++i) {
+            submit(pool, pending);
+        }
+        allocated += allocations.load(std::memory_order_relaxed) - before;
+        for (auto left = pending.load(); left != 0; left = pending.load()) {
+            pending.wait(left);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["allocs_per_task"] =
+        static_cast<double>(allocated) / static_cast<double>(state.iterations() * count);
+}
+
+static void done(std::atomic<std::int64_t>& pending) {
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pending.notify_one();
+    }
+}
+
+static void BM_Submit_Enqueue(benchmark::State& state) {
+    submissions(state, static_cast<scheduling>(state.range(0)), [](auto& pool, auto& pending) {
+        pool.enqueue(done, std::ref(pending));
+    });
+}
+BENCHMARK(BM_Submit_Enqueue)->Arg(0)->Arg(1)->UseRealTime();
+
+static void BM_Submit_Future(benchmark::State& state) {
+    submissions(state, static_cast<scheduling>(state.range(0)), [](auto& pool, auto& pending) {
+        pool.submit(done, std::ref(pending));
+    });
+}
+BENCHMARK(BM_Submit_Future)->Arg(0)->Arg(1)->UseRealTime();
+
+static void BM_Submit_Detached(benchmark::State& state) {
+    submissions(state, static_cast<scheduling>(state.range(0)), [](auto& pool, auto& pending) {
+        pool.submit_detached([&pending]() { done(pending); });
+    });
+}
+BENCHMARK(BM_Submit_Detached)->Arg(0)->Arg(1)->UseRealTime();
+
+// A frame of 4 layers of 8 systems, each system depending on every system of the layer before.
+constexpr auto k_layers = 4;
+constexpr auto k_width  = 8;
+
+static void system_work() {
+    auto value = 1U;
+    for (auto i = 0; i < 2000; ++i) {
+        value = value * 1664525U + 1013904223U;
+    }
+    benchmark::DoNotOptimize(value);
+}
+
+static void frame_counters(benchmark::State& state, const std::int64_t allocated) {
+    state.SetItemsProcessed(state.iterations() * k_layers * k_width);
+    state.counters["allocs_per_frame"] =
+        static_cast<double>(allocated) / static_cast<double>(state.iterations());
+}
+
+// Systems wait for their dependencies with future::get() inside the workers. The FIFO shared
+// queue keeps this from deadlocking, as dependencies are always dequeued first.
+static void BM_Frame_ChainedFutures(benchmark::State& state) {
+    thread_pool pool(static_cast<std::size_t>(state.range(0)), scheduling::shared_queue);
+    std::int64_t allocated{};
+    for (auto _ : state) {
+        const auto before = allocations.load(std::memory_order_relaxed);
+        std::vector<std::shared_future<void>> previous;
+        for (auto layer = 0; layer < k_layers; ++layer) {
+            std::vector<std::shared_future<void>> current;
+            for (auto i = 0; i < k_width; ++i) {
+                current.emplace_back(pool.enqueue([previous] {
+                    for (const auto& future : previous) {
+                        future.get();
+                    }
+                    system_work();
+                }));
+            }
+            previous = std::move(current);
+        }
+        for (const auto& future : previous) {
+            future.get();
+        }
+        allocated += allocations.load(std::memory_order_relaxed) - before;
+    }
+    frame_counters(state, allocated);
+}
+BENCHMARK(BM_Frame_ChainedFutures)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void frame_graph(benchmark::State& state, const scheduling mode) {
+    thread_pool pool(static_cast<std::size_t>(state.range(0)), mode);
+    task_graph graph;
+    for (auto layer = 0; layer < k_layers; ++layer) {
+        for (auto i = 0; i < k_width; ++i) {
+            const auto node = graph.emplace(system_work);
+            for (auto before = 0; layer != 0 && before < k_width; ++before) {
+                graph.precede(static_cast<std::size_t>((layer - 1) * k_width + before), node);
+            }
+        }
+    }
+    graph.run(pool);
+
+    std::int64_t allocated{};
+    for (auto _ : state) {
+        const auto before = allocations.load(std::memory_order_relaxed);
+        graph.run(pool);
+        allocated += allocations.load(std::memory_order_relaxed) - before;
+    }
+    frame_counters(state, allocated);
+    state.counters["critical_path_us"] =
+        static_cast<double>(graph.timings().critical_path_length.count()) / 1000.;
+}
+
+static void BM_Frame_Graph_SharedQueue(benchmark::State& state) {
+    frame_graph(state, scheduling::shared_queue);
+}
+BENCHMARK(BM_Frame_Graph_SharedQueue)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void BM_Frame_Graph_WorkStealing(benchmark::State& state) {
+    frame_graph(state, scheduling::work_stealing);
+}
+BENCHMARK(BM_Frame_Graph_WorkStealing)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Bulk jobs fill both workers, then a probe measures how long a task waits before it starts. Only
+// that wait is timed, the bulk jobs are drained between iterations.
+static void probe_latency(benchmark::State& state, const task_priority priority) {
+    thread_pool pool(2, static_cast<scheduling>(state.range(0)));
+    constexpr auto bulk = 64;
+    std::atomic<std::int64_t> pending;
+    std::vector<double> latencies;
+    for (auto _ : state) {
+        pending.store(bulk, std::memory_order_relaxed);
+        for (auto i = 0; i < bulk; ++i) {
+            pool.submit_detached([&pending] {
+                system_work();
+                done(pending);
+            });
+        }
+        const auto submitted = std::chrono::steady_clock::now();
+        auto probe           = pool.submit({ .priority = priority }, [submitted] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - submitted);
+        });
+        const auto latency = probe.get().count();
+        state.SetIterationTime(latency);
+        latencies.emplace_back(latency);
+        for (auto left = pending.load(); left != 0; left = pending.load()) {
+            pending.wait(left);
+        }
+    }
+    std::ranges::sort(latencies);
+    state.counters["p99_us"] = latencies[latencies.size() * 99 / 100] * 1e6;
+}
+
+static void BM_ProbeLatency_Normal(benchmark::State& state) {
+    probe_latency(state, task_priority::normal);
+}
+BENCHMARK(BM_ProbeLatency_Normal)->Arg(0)->Arg(1)->UseManualTime();
+
+static void BM_ProbeLatency_High(benchmark::State& state) {
+    probe_latency(state, task_priority::high);
+}
+BENCHMARK(BM_ProbeLatency_High)->Arg(0)->Arg(1)->UseManualTime();
+
+// A pipeline of 3 stages, each running on the pool after the previous one.
+constexpr auto k_stages = 3;
+
+static void BM_Pipeline_BlockingFutures(benchmark::State& state) {
+    thread_pool pool(2, scheduling::work_stealing);
+    for (auto _ : state) {
+        auto value = 0;
+        for (auto stage = 0; stage < k_stages; ++stage) {
+            value = pool.submit([value] { return value + 1; }).get();
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * k_stages);
+}
+BENCHMARK(BM_Pipeline_BlockingFutures)->UseRealTime();
+
+static auto pipeline_stage(thread_pool& pool, const int value) -> task<int> {
+    co_await schedule_on(pool);
+    co_return value + 1;
+}
+
+static auto pipeline(thread_pool& pool) -> task<int> {
+    auto value = 0;
+    for (auto stage = 0; stage < k_stages; ++stage) {
+        value = co_await pipeline_stage(pool, value);
+    }
+    co_return value;
+}
+
+static void BM_Pipeline_Tasks(benchmark::State& state) {
+    thread_pool pool(2, scheduling::work_stealing);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sync_wait(pipeline(pool)));
+    }
+    state.SetItemsProcessed(state.iterations() * k_stages);
+}
+BENCHMARK(BM_Pipeline_Tasks)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 
 #ifndef CPP23
     #if _HAS_CXX23 && __cplusplus >= 202302L
@@ -31,6 +32,15 @@
     #define NOVTABLE
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+    #define ATOM_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    #include <xmmintrin.h>
+    #define ATOM_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+    #define ATOM_PREFETCH(addr)
+#endif
+
 #if defined(_DEBUG)
     #define ATOM_RELEASE_INLINE
     #define ATOM_DEBUG_SHOW_FUNC constexpr std::string_view _this_func = ATOM_FUNCNAME;
@@ -129,3 +139,15 @@ constexpr auto magic_512             = 0x200;
 constexpr auto magic_1024            = 0x400;
 constexpr auto magic_one_half        = 0.5F;
 constexpr auto magic_double_one_half = 0.5;
+
+namespace atom::utils {
+
+/**
+ * @brief Size of a cache line, used to keep data written by different threads apart.
+ *
+ * Fixed, as GCC warns that `std::hardware_destructive_interference_size` may change with tuning
+ * flags, and so would the layout of every type aligned to it.
+ */
+constexpr std::size_t cache_line_size = 64;
+
+} // namespace atom::utils
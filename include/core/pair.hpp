@@ -587,7 +587,7 @@ public:
             return pair_.first();
         }
         else {
-            static_assert(false, "No valid way to get the first value.");
+            static_assert(dependent_false_v<First>, "No valid way to get the first value.");
         }
     }
 
@@ -599,7 +599,7 @@ public:
             return pair_.first();
         }
         else {
-            static_assert(false, "No valid way to get the first value.");
+            static_assert(dependent_false_v<First>, "No valid way to get the first value.");
         }
     }
 
@@ -611,7 +611,7 @@ public:
             return pair_.second();
         }
         else {
-            static_assert(false, "No valid way to get the second value.");
+            static_assert(dependent_false_v<Second>, "No valid way to get the second value.");
         }
     }
 
@@ -623,7 +623,7 @@ public:
             return pair_.second();
         }
         else {
-            static_assert(false, "No valid way to get the second value.");
+            static_assert(dependent_false_v<Second>, "No valid way to get the second value.");
         }
     }
 
@@ -15,6 +15,13 @@ namespace atom::utils {
 template <typename Ty>
 [[nodiscard]] Ty fake_copy_init(Ty) noexcept;
 
+/**
+ * @brief Always false, but only known once `Tys` are, so it can fail a discarded branch.
+ *
+ */
+template <typename... Tys>
+constexpr bool dependent_false_v = false;
+
 template <std::integral auto Integral>
 struct is_zero : std::false_type {};
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <memory>
 #include "concepts/mempool.hpp"
 
@@ -14,10 +15,14 @@ class allocator;
 
 class basic_storage;
 
-template <typename Ty, typename Alloc = std::allocator<Ty>>
+template <typename Ty, typename Alloc = std::allocator<Ty>, std::size_t InlineSize = 0>
 class unique_storage;
 
-template <typename Ty, typename Alloc = std::allocator<Ty>>
+struct atomic_refcount;
+
+struct plain_refcount;
+
+template <typename Ty, typename Alloc = std::allocator<Ty>, typename RefCount = atomic_refcount>
 class shared_storage;
 
 } // namespace atom::utils
@@ -2,9 +2,11 @@
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <numeric>
 #include <type_traits>
 #include "concepts/mempool.hpp"
 #include "concepts/type.hpp"
+#include "core/langdef.hpp"
 #include "memory.hpp"
 
 namespace atom::utils {
@@ -76,10 +78,12 @@ struct standard_allocator : public basic_allocator, private std::allocator<Ty> {
         deallocate(static_cast<Ty*>(ptr), count);
     }
 
-    [[nodiscard]] constexpr Ty* allocate(const size_type count = 1) { return allocate(count); }
+    [[nodiscard]] constexpr Ty* allocate(const size_type count = 1) {
+        return std::allocator<Ty>::allocate(count);
+    }
 
     constexpr void deallocate(Ty* ptr, const size_type count = 1) noexcept {
-        deallocate(ptr, count);
+        std::allocator<Ty>::deallocate(ptr, count);
     }
 
     constexpr bool operator==(const standard_allocator&) const noexcept { return true; }
@@ -163,14 +167,14 @@ public:
     [[nodiscard]] auto allocate(const size_t count = 1) -> Ty* {
         return pool_->template allocate<Ty>(
             count, static_cast<std::align_val_t>(
-                       std::min<std::size_t>(alignof(Ty), ::atom::utils::internal::min_align)));
+                       std::max<std::size_t>(alignof(Ty), ::atom::utils::internal::min_align)));
     }
 
     constexpr void deallocate(Ty* const ptr, const size_t count = 1) {
         pool_->template deallocate<Ty>(
             ptr, count,
             static_cast<std::align_val_t>(
-                std::min<std::size_t>(alignof(Ty), ::atom::utils::internal::min_align)));
+                std::max<std::size_t>(alignof(Ty), ::atom::utils::internal::min_align)));
     }
 
     [[nodiscard]] bool operator==(const allocator& that) const noexcept {
@@ -290,7 +294,7 @@ public:
     template <typename Other, size_t Count_ = 1>
     using rebind_t = builtin_storage_allocator<Other, Count_>;
 
-    constexpr builtin_storage_allocator() noexcept : storage_() { _Gen_ptrs() };
+    constexpr builtin_storage_allocator() noexcept : storage_() { _Gen_ptrs(); }
     constexpr builtin_storage_allocator(const builtin_storage_allocator&) noexcept : storage_() { _Gen_ptrs(); }
     constexpr builtin_storage_allocator(builtin_storage_allocator&&) noexcept : storage_() { _Gen_ptrs(); }
 
@@ -311,13 +315,13 @@ public:
     constexpr explicit builtin_storage_allocator(const builtin_storage_allocator<Other>&) noexcept
         : storage_() {}
 
-    constexpr auto allocate() const noexcept -> Ty* {
+    constexpr auto allocate() noexcept -> Ty* {
         // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
         return ptrs_[begin_++ & _Mask];
         // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
     }
 
-    constexpr void deallocate(Ty* const ptr) const noexcept {
+    constexpr void deallocate(Ty* const ptr) noexcept {
         ptrs_[end_++ & _Mask] = ptr;
     }
 
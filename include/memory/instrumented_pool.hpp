@@ -0,0 +1,383 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "concepts/mempool.hpp"
+#include "core/langdef.hpp"
+
+/**
+ * @brief Set to 1 to let `instrumented_pool` record statistics.
+ *
+ * When it is 0, the default, recording compiles to nothing and every snapshot is empty, so
+ * instrumented pools can be left in place in release builds.
+ */
+#ifndef ATOM_POOL_INSTRUMENTATION
+    #define ATOM_POOL_INSTRUMENTATION 0
+#endif
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Readable name of a type, taken from the signature of this function.
+ *
+ */
+template <typename Ty>
+[[nodiscard]] constexpr auto allocation_type_name() noexcept -> std::string_view {
+    constexpr std::string_view signature = ATOM_FUNCNAME;
+#ifdef _MSC_VER
+    constexpr std::string_view prefix = "allocation_type_name<";
+    constexpr std::string_view suffix = ">(void)";
+    const auto first                  = signature.find(prefix) + prefix.size();
+    return signature.substr(first, signature.rfind(suffix) - first);
+#else
+    constexpr std::string_view prefix = "Ty = ";
+    const auto first                  = signature.find(prefix) + prefix.size();
+    return signature.substr(first, signature.find_first_of(";]", first) - first);
+#endif
+}
+
+/**
+ * @brief Address identifying a type without RTTI.
+ *
+ */
+template <typename Ty>
+inline constexpr char allocation_type_tag{};
+
+inline void append_json_string(std::string& out, const std::string_view text) {
+    out += '"';
+    for (const auto character : text) {
+        if (character == '"' || character == '\\') {
+            out += '\\';
+        }
+        out += character;
+    }
+    out += '"';
+}
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Statistics of an `instrumented_pool` at one point in time.
+ *
+ * Sizes are classed by the next power of two. Every figure but the totals covers live memory only.
+ */
+struct allocation_snapshot {
+    using size_type = std::size_t;
+
+    struct size_class {
+        size_type block_size;
+        size_type live_bytes;
+        size_type live_blocks;
+        size_type allocations;
+    };
+
+    struct type_usage {
+        std::string_view name;
+        size_type live_bytes;
+        size_type live_objects;
+        size_type allocations;
+    };
+
+    /// @brief Classes that have been allocated from, smallest first.
+    std::vector<size_class> classes;
+    /// @brief Types that have been allocated, most live bytes first.
+    std::vector<type_usage> types;
+    size_type live_bytes;
+    size_type peak_bytes;
+    size_type allocations;
+    size_type deallocations;
+    /// @brief Allocations per second since the pool was created.
+    double allocation_rate;
+    /// @brief Share of the live size classes left unused by the live requests, from 0 to 1.
+    double fragmentation;
+
+    /**
+     * @brief Dump as a JSON object.
+     *
+     */
+    [[nodiscard]] auto to_json() const -> std::string {
+        std::string out = "{";
+        const auto field = [&out](const std::string_view name, const auto value) {
+            internal::append_json_string(out, name);
+            out += ':';
+            out += std::to_string(value);
+            out += ',';
+        };
+
+        field("live_bytes", live_bytes);
+        field("peak_bytes", peak_bytes);
+        field("allocations", allocations);
+        field("deallocations", deallocations);
+        field("allocation_rate", allocation_rate);
+        field("fragmentation", fragmentation);
+
+        out += "\"classes\":[";
+        for (const auto& entry : classes) {
+            out += '{';
+            field("block_size", entry.block_size);
+            field("live_bytes", entry.live_bytes);
+            field("live_blocks", entry.live_blocks);
+            field("allocations", entry.allocations);
+            out.back() = '}';
+            out += ',';
+        }
+        if (!classes.empty()) {
+            out.pop_back();
+        }
+
+        out += "],\"types\":[";
+        for (const auto& entry : types) {
+            out += "{\"name\":";
+            internal::append_json_string(out, entry.name);
+            out += ',';
+            field("live_bytes", entry.live_bytes);
+            field("live_objects", entry.live_objects);
+            field("allocations", entry.allocations);
+            out.back() = '}';
+            out += ',';
+        }
+        if (!types.empty()) {
+            out.pop_back();
+        }
+        out += "]}";
+        return out;
+    }
+};
+
+/**
+ * @brief Counters behind an `instrumented_pool`, safe to update from several threads.
+ *
+ * Counters are relaxed atomics. Each type gets its record the first time it is allocated, which
+ * takes an exclusive lock; finding it later takes a shared one.
+ */
+class allocation_stats {
+public:
+    using size_type = std::size_t;
+
+    allocation_stats() noexcept : start_(std::chrono::steady_clock::now()) {}
+
+    allocation_stats(const allocation_stats&)            = delete;
+    allocation_stats& operator=(const allocation_stats&) = delete;
+
+    ~allocation_stats() = default;
+
+    template <typename Ty>
+    void on_allocate([[maybe_unused]] const size_type count) {
+#if ATOM_POOL_INSTRUMENTATION
+        const auto bytes = sizeof(Ty) * count;
+        auto& entry      = classes_[class_of(bytes)];
+        entry.live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        entry.live_blocks.fetch_add(1, std::memory_order_relaxed);
+        entry.allocations.fetch_add(1, std::memory_order_relaxed);
+
+        auto& type = record_of<Ty>();
+        type.live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        type.live_objects.fetch_add(count, std::memory_order_relaxed);
+        type.allocations.fetch_add(1, std::memory_order_relaxed);
+
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        const auto live = live_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak       = peak_bytes_.load(std::memory_order_relaxed);
+        while (peak < live &&
+               !peak_bytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+#endif
+    }
+
+    template <typename Ty>
+    void on_deallocate([[maybe_unused]] const size_type count) {
+#if ATOM_POOL_INSTRUMENTATION
+        const auto bytes = sizeof(Ty) * count;
+        auto& entry      = classes_[class_of(bytes)];
+        entry.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        entry.live_blocks.fetch_sub(1, std::memory_order_relaxed);
+
+        auto& type = record_of<Ty>();
+        type.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        type.live_objects.fetch_sub(count, std::memory_order_relaxed);
+
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        live_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+#endif
+    }
+
+    [[nodiscard]] auto snapshot() const -> allocation_snapshot {
+        allocation_snapshot result{};
+#if ATOM_POOL_INSTRUMENTATION
+        size_type requested{};
+        size_type reserved{};
+        for (size_type index = 0; index < classes_.size(); ++index) {
+            const auto& entry = classes_[index];
+            const auto count  = entry.allocations.load(std::memory_order_relaxed);
+            if (count == 0) {
+                continue;
+            }
+            const auto block = size_type{ 1 } << index;
+            const auto live  = entry.live_blocks.load(std::memory_order_relaxed);
+            const auto bytes = entry.live_bytes.load(std::memory_order_relaxed);
+            result.classes.push_back({ block, bytes, live, count });
+            requested += bytes;
+            reserved += live * block;
+        }
+
+        {
+            std::shared_lock lock{ mutex_ };
+            for (const auto& [tag, record] : types_) {
+                result.types.push_back({ record->name,
+                                         record->live_bytes.load(std::memory_order_relaxed),
+                                         record->live_objects.load(std::memory_order_relaxed),
+                                         record->allocations.load(std::memory_order_relaxed) });
+            }
+        }
+        std::ranges::sort(result.types, [](const auto& lhs, const auto& rhs) {
+            return lhs.live_bytes > rhs.live_bytes;
+        });
+
+        result.live_bytes    = live_bytes_.load(std::memory_order_relaxed);
+        result.peak_bytes    = peak_bytes_.load(std::memory_order_relaxed);
+        result.allocations   = allocations_.load(std::memory_order_relaxed);
+        result.deallocations = deallocations_.load(std::memory_order_relaxed);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        result.allocation_rate =
+            elapsed.count() > 0 ? static_cast<double>(result.allocations) / elapsed.count() : 0;
+        result.fragmentation =
+            reserved != 0 ? 1.0 - static_cast<double>(requested) / static_cast<double>(reserved)
+                          : 0;
+#endif
+        return result;
+    }
+
+private:
+    struct class_record {
+        std::atomic<size_type> live_bytes;
+        std::atomic<size_type> live_blocks;
+        std::atomic<size_type> allocations;
+    };
+
+    struct type_record {
+        std::string_view name;
+        std::atomic<size_type> live_bytes;
+        std::atomic<size_type> live_objects;
+        std::atomic<size_type> allocations;
+    };
+
+    [[nodiscard]] static auto class_of(const size_type bytes) noexcept -> size_type {
+        return std::bit_width(std::max<size_type>(bytes, 1) - 1);
+    }
+
+    template <typename Ty>
+    auto record_of() -> type_record& {
+        const void* const tag = &internal::allocation_type_tag<Ty>;
+        {
+            std::shared_lock lock{ mutex_ };
+            if (const auto iter = types_.find(tag); iter != types_.end()) [[likely]] {
+                return *iter->second;
+            }
+        }
+        std::unique_lock lock{ mutex_ };
+        auto& record = types_[tag];
+        if (!record) {
+            record       = std::make_unique<type_record>();
+            record->name = internal::allocation_type_name<Ty>();
+        }
+        return *record;
+    }
+
+    std::array<class_record, sizeof(size_type) * 8 + 1> classes_{};
+    std::atomic<size_type> live_bytes_{};
+    std::atomic<size_type> peak_bytes_{};
+    std::atomic<size_type> allocations_{};
+    std::atomic<size_type> deallocations_{};
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<const void*, std::unique_ptr<type_record>> types_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Memory pool forwarding to another one and recording what goes through it.
+ *
+ * Works with any memory pool, and copies share the same statistics. Unless
+ * `ATOM_POOL_INSTRUMENTATION` is set, nothing is recorded and the only cost left is the forwarding.
+ * @tparam Pool The pool allocating the memory.
+ */
+template <concepts::mempool Pool>
+class instrumented_pool {
+public:
+    using upstream_type = typename Pool::shared_type;
+    using size_type     = std::size_t;
+    class pool;
+    using shared_type = std::shared_ptr<pool>;
+
+    class pool {
+    public:
+        using size_type = instrumented_pool::size_type;
+
+        explicit pool(upstream_type upstream) noexcept(
+            std::is_nothrow_move_constructible_v<upstream_type>)
+            : upstream_(std::move(upstream)) {}
+
+        pool(const pool&)            = delete;
+        pool(pool&&)                 = delete;
+        pool& operator=(const pool&) = delete;
+        pool& operator=(pool&&)      = delete;
+        ~pool()                      = default;
+
+        // not `ALLOCATOR`, the upstream may hand out memory of a buffer it does not own.
+        template <typename Ty>
+        auto allocate(
+            const size_type count = 1, const std::align_val_t align = std::align_val_t{ 16 })
+            -> Ty* {
+            auto* const ptr = upstream_->template allocate<Ty>(count, align);
+            stats_.template on_allocate<Ty>(count);
+            return ptr;
+        }
+
+        template <typename Ty>
+        void deallocate(
+            Ty* const ptr, const size_type count = 1,
+            const std::align_val_t align = std::align_val_t{ 16 }) {
+            stats_.template on_deallocate<Ty>(count);
+            upstream_->template deallocate<Ty>(ptr, count, align);
+        }
+
+        [[nodiscard]] auto stats() const noexcept -> const allocation_stats& { return stats_; }
+
+    private:
+        upstream_type upstream_;
+        allocation_stats stats_;
+    };
+
+    explicit instrumented_pool(upstream_type upstream)
+        : pool_(std::make_shared<pool>(std::move(upstream))) {}
+
+    explicit instrumented_pool(Pool& upstream)
+    requires requires {
+        { upstream.get() } -> std::same_as<upstream_type>;
+    }
+        : instrumented_pool(upstream.get()) {}
+
+    auto get() -> shared_type { return pool_; }
+    auto get() const -> const shared_type { return pool_; }
+
+    [[nodiscard]] auto snapshot() const -> allocation_snapshot { return pool_->stats().snapshot(); }
+
+private:
+    shared_type pool_;
+};
+
+} // namespace atom::utils
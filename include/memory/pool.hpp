@@ -1,14 +1,48 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <stack>
+#include <new>
+#include <utility>
+#include <vector>
 #include "core.hpp"
 #include "core/langdef.hpp"
+#include "thread/lock.hpp"
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
 
 namespace atom::utils {
 
+/**
+ * @brief Where pools get their chunks and their largest blocks from.
+ *
+ * Both options are hints. They only take effect on Linux and fall back to what is available, so
+ * they are safe to enable everywhere.
+ */
+struct pool_backing {
+    /**
+     * @brief Map chunks in 2 MiB regions backed by huge pages, explicit ones when reserved, or
+     * transparent ones otherwise. Blocks of at least 2 MiB are mapped the same way.
+     *
+     */
+    bool huge_pages{};
+    /**
+     * @brief Prefer the NUMA node of the thread mapping a region. Only applies to mapped memory.
+     *
+     */
+    bool numa_local{};
+};
+
 namespace internal {
 
 const std::align_val_t default_align{ 16 };
@@ -24,42 +58,535 @@ constexpr bool is_pow_of_two(const SizeTy size) {
     return size > 0 && (size & (size - 1)) == 0;
 }
 
+/**
+ * @brief Power-of-two size classes shared by the pools.
+ *
+ * Chunks are aligned to the largest class, so every block is aligned to its own size and a request
+ * is served by the smallest class covering both its size and its alignment.
+ */
+struct size_classes {
+    constexpr static std::size_t min_block_size = 16;
+    constexpr static std::size_t max_block_size = 4096;
+    constexpr static std::size_t chunk_size     = 64 * 1024;
+    constexpr static std::size_t count =
+        std::bit_width(max_block_size) - std::bit_width(min_block_size) + 1;
+
+    [[nodiscard]] constexpr static auto fits(
+        const std::size_t size, const std::size_t alignment) noexcept -> bool {
+        return size <= max_block_size && alignment <= max_block_size;
+    }
+
+    [[nodiscard]] constexpr static auto index_of(
+        const std::size_t size, const std::size_t alignment) noexcept -> std::size_t {
+        const auto block = std::max({ size, alignment, min_block_size });
+        return std::bit_width(block - 1) - std::bit_width(min_block_size - 1);
+    }
+
+    [[nodiscard]] constexpr static auto block_size(const std::size_t index) noexcept
+        -> std::size_t {
+        return min_block_size << index;
+    }
+
+};
+
+constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+#if defined(__linux__)
+constexpr bool can_map_pages = true;
+
+/**
+ * @brief Prefer the NUMA node the calling thread runs on for a range not touched yet.
+ *
+ * Calls the kernel directly, so libnuma is not needed. Failing, on a kernel without NUMA for
+ * example, leaves the default policy in place.
+ */
+inline void prefer_local_node(void* const ptr, const std::size_t size) noexcept {
+    unsigned cpu{};
+    unsigned node{};
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return;
+    }
+    constexpr auto bits          = sizeof(unsigned long) * 8;
+    constexpr int mpol_preferred = 1;
+    std::array<unsigned long, 16> mask{};
+    if (node >= mask.size() * bits) {
+        return;
+    }
+    mask[node / bits] = 1UL << (node % bits);
+    ::syscall(SYS_mbind, ptr, size, mpol_preferred, mask.data(), mask.size() * bits, 0U);
+}
+
+/**
+ * @brief Map anonymous memory, a multiple of the huge page size, aligned to it.
+ *
+ * Explicit huge pages are tried first. Without any reserved, a larger range is mapped and trimmed
+ * to the alignment, then advised to be backed by transparent huge pages.
+ */
+[[nodiscard]] inline auto map_pages(const std::size_t size, const pool_backing backing) -> void* {
+    void* ptr = MAP_FAILED;
+    #if defined(MAP_HUGETLB)
+    if (backing.huge_pages) {
+        constexpr auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+        ptr                  = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    }
+    #endif
+    if (ptr == MAP_FAILED) {
+        const auto mapped = size + huge_page_size;
+        auto* const raw   = static_cast<std::byte*>(
+            ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+        const auto address = reinterpret_cast<std::uintptr_t>(raw);
+        const auto head    = (huge_page_size - address % huge_page_size) % huge_page_size;
+        if (head != 0) {
+            ::munmap(raw, head);
+        }
+        ::munmap(raw + head + size, huge_page_size - head);
+        ptr = raw + head;
+    #if defined(MADV_HUGEPAGE)
+        if (backing.huge_pages) {
+            ::madvise(ptr, size, MADV_HUGEPAGE);
+        }
+    #endif
+    }
+    if (backing.numa_local) {
+        prefer_local_node(ptr, size);
+    }
+    return ptr;
+}
+
+inline void unmap_pages(void* const ptr, const std::size_t size) noexcept { ::munmap(ptr, size); }
+#else
+constexpr bool can_map_pages = false;
+
+[[nodiscard]] inline auto map_pages(const std::size_t, const pool_backing) -> void* {
+    throw std::bad_alloc{};
+}
+
+inline void unmap_pages(void* const, const std::size_t) noexcept {}
+#endif
+
+/**
+ * @brief Chunks of a pool and its blocks too large for any class, owning every chunk.
+ *
+ * By default chunks come from `operator new`. When the backing asks for huge pages or NUMA
+ * placement, they are carved from mapped 2 MiB regions instead, which are only unmapped with the
+ * source. Large blocks are mapped on their own when huge pages are asked for and they span at
+ * least one, so the choice only depends on the request and deallocating takes the same path.
+ */
+class chunk_source {
+public:
+    explicit chunk_source(const pool_backing backing = {}) noexcept
+        : backing_(backing), mapped_(can_map_pages && (backing.huge_pages || backing.numa_local)) {}
+
+    chunk_source(const chunk_source&)            = delete;
+    chunk_source& operator=(const chunk_source&) = delete;
+
+    ~chunk_source() noexcept {
+        for (auto* const chunk : chunks_) {
+            if (mapped_) {
+                unmap_pages(chunk, huge_page_size);
+            }
+            else {
+                operator delete(
+                    chunk, size_classes::chunk_size,
+                    std::align_val_t{ size_classes::max_block_size });
+            }
+        }
+    }
+
+    [[nodiscard]] auto allocate_chunk() -> std::byte* {
+        chunks_.reserve(chunks_.size() + 1);
+        if (!mapped_) {
+            auto* const chunk = static_cast<std::byte*>(operator new(
+                size_classes::chunk_size, std::align_val_t{ size_classes::max_block_size }));
+            chunks_.push_back(chunk);
+            return chunk;
+        }
+        if (cursor_ == region_end_) {
+            cursor_ = static_cast<std::byte*>(map_pages(huge_page_size, backing_));
+            chunks_.push_back(cursor_);
+            region_end_ = cursor_ + huge_page_size;
+        }
+        auto* const chunk = cursor_;
+        cursor_ += size_classes::chunk_size;
+        return chunk;
+    }
+
+    [[nodiscard]] auto allocate_large(const std::size_t size, const std::align_val_t align)
+        -> void* {
+        if (maps(size, align)) {
+            return map_pages(round_to_huge_pages(size), backing_);
+        }
+        return operator new(size, align);
+    }
+
+    void deallocate_large(
+        void* const ptr, const std::size_t size, const std::align_val_t align) noexcept {
+        if (maps(size, align)) {
+            unmap_pages(ptr, round_to_huge_pages(size));
+            return;
+        }
+        operator delete(ptr, size, align);
+    }
+
+private:
+    [[nodiscard]] auto maps(const std::size_t size, const std::align_val_t align) const noexcept
+        -> bool {
+        return can_map_pages && backing_.huge_pages && size >= huge_page_size &&
+               static_cast<std::size_t>(align) <= size_classes::max_block_size;
+    }
+
+    [[nodiscard]] static auto round_to_huge_pages(const std::size_t size) noexcept
+        -> std::size_t {
+        return (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+
+    pool_backing backing_;
+    bool mapped_;
+    std::byte* cursor_{};
+    std::byte* region_end_{};
+    // chunks from `operator new`, or whole regions when mapped.
+    std::vector<void*> chunks_;
+};
+
+/**
+ * @brief Free block, linked to the next one. Only the first block of a batch handed between
+ * threads uses `next_batch`.
+ *
+ */
+struct free_block {
+    free_block* next;
+    free_block* next_batch;
+};
+
+static_assert(sizeof(free_block) <= size_classes::min_block_size);
+
+/**
+ * @brief Link the blocks of a chunk in address order in front of `head`.
+ *
+ */
+inline auto carve_chunk(std::byte* const chunk, const std::size_t block_size, free_block* head)
+    -> free_block* {
+    for (auto offset = size_classes::chunk_size; offset != 0;) {
+        offset -= block_size;
+        head = ::new (static_cast<void*>(chunk + offset)) free_block{ head, nullptr };
+    }
+    return head;
+}
+
+/**
+ * @brief Shared state of a `synchronized_pool`, kept alive by every thread caching its blocks.
+ *
+ * Each class has a stack of batches, linked through their first block. Pushing a batch is a CAS
+ * on the top. Popping one is a CAS too, under a short lock of the class, so no block is popped
+ * and pushed back while another thread reads its link, and there is no ABA problem.
+ */
+struct synchronized_pool_state {
+    explicit synchronized_pool_state(const pool_backing backing) noexcept : source(backing) {}
+
+    synchronized_pool_state(const synchronized_pool_state&)            = delete;
+    synchronized_pool_state& operator=(const synchronized_pool_state&) = delete;
+
+    ~synchronized_pool_state() noexcept = default;
+
+    void push(const std::size_t index, free_block* const batch) noexcept {
+        auto& top = central[index];
+        auto* old = top.load(std::memory_order_relaxed);
+        do {
+            batch->next_batch = old;
+        } while (!top.compare_exchange_weak(
+            old, batch, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Take one batch from the central stack of the class, or nullptr.
+     *
+     */
+    auto pop(const std::size_t index) noexcept -> free_block* {
+        auto& top = central[index];
+        const std::lock_guard lock{ pop_locks[index] };
+        auto* batch = top.load(std::memory_order_acquire);
+        // only pushes may race, and they leave the popped batch alone.
+        while (batch != nullptr && !top.compare_exchange_weak(
+                                       batch, batch->next_batch, std::memory_order_acquire,
+                                       std::memory_order_acquire)) {}
+        return batch;
+    }
+
+    auto new_chunk() -> std::byte* {
+        std::lock_guard lock{ mutex };
+        return source.allocate_chunk();
+    }
+
+    std::array<std::atomic<free_block*>, size_classes::count> central{};
+    std::array<spin_lock, size_classes::count> pop_locks;
+    std::atomic<bool> alive{ true };
+    std::mutex mutex;
+    // only allocating chunks takes the mutex, large blocks are thread-safe.
+    chunk_source source;
+};
+
+/**
+ * @brief Blocks of one `synchronized_pool` cached by one thread.
+ *
+ */
+struct synchronized_pool_cache {
+    struct list {
+        free_block* head{};
+        std::size_t count{};
+    };
+
+    /**
+     * @brief Blocks moved between a thread and the central stacks at once.
+     *
+     */
+    [[nodiscard]] constexpr static auto batch_size(const std::size_t index) noexcept
+        -> std::size_t {
+        return std::clamp<std::size_t>(
+            32 * 1024 / size_classes::block_size(index), 8, 256);
+    }
+
+    explicit synchronized_pool_cache(std::shared_ptr<synchronized_pool_state> state) noexcept
+        : state(std::move(state)) {}
+
+    synchronized_pool_cache(const synchronized_pool_cache&)            = delete;
+    synchronized_pool_cache& operator=(const synchronized_pool_cache&) = delete;
+
+    ~synchronized_pool_cache() noexcept { flush(); }
+
+    auto allocate(const std::size_t index) -> void* {
+        auto& cached = lists[index];
+        if (cached.head == nullptr) [[unlikely]] {
+            refill(index);
+        }
+        auto* const block = cached.head;
+        cached.head       = block->next;
+        --cached.count;
+        return block;
+    }
+
+    void deallocate(const std::size_t index, void* const ptr) noexcept {
+        auto& cached = lists[index];
+        cached.head  = ::new (ptr) free_block{ cached.head, nullptr };
+        if (++cached.count > 2 * batch_size(index)) [[unlikely]] {
+            release(index, batch_size(index), batch_size(index));
+        }
+    }
+
+    /**
+     * @brief Give every cached block back to the central stacks.
+     *
+     */
+    void flush() noexcept {
+        for (std::size_t index = 0; index < lists.size(); ++index) {
+            while (lists[index].head != nullptr) {
+                release(index, 0, batch_size(index));
+            }
+            lists[index].count = 0;
+        }
+    }
+
+    void refill(const std::size_t index) {
+        auto& cached = lists[index];
+        if (auto* const batch = state->pop(index)) {
+            // flushed batches may be short, and these blocks are about to be handed out anyway.
+            std::size_t count = 0;
+            for (const auto* block = batch; block != nullptr; block = block->next) {
+                ++count;
+            }
+            cached.head  = batch;
+            cached.count = count;
+            return;
+        }
+        // the chunk is shared right away, keeping a single batch here.
+        cached.head  = carve_chunk(state->new_chunk(), size_classes::block_size(index), nullptr);
+        cached.count = size_classes::chunk_size / size_classes::block_size(index);
+        while (cached.count > batch_size(index)) {
+            release(index, batch_size(index), batch_size(index));
+        }
+    }
+
+    /**
+     * @brief Move up to `count` blocks to the central stack, skipping the first `keep` blocks of
+     * the cached list, which are the most recently freed.
+     *
+     */
+    void release(
+        const std::size_t index, const std::size_t keep, const std::size_t count) noexcept {
+        auto& cached       = lists[index];
+        free_block** front = &cached.head;
+        for (std::size_t skipped = 0; skipped < keep && *front != nullptr; ++skipped) {
+            front = &(*front)->next;
+        }
+        auto* const first = *front;
+        if (first == nullptr) {
+            return;
+        }
+        auto* last        = first;
+        std::size_t moved = 1;
+        while (moved < count && last->next != nullptr) {
+            last = last->next;
+            ++moved;
+        }
+        *front       = last->next;
+        last->next   = nullptr;
+        cached.count = cached.count - std::min(cached.count, moved);
+        state->push(index, first);
+    }
+
+    std::shared_ptr<synchronized_pool_state> state;
+    std::array<list, size_classes::count> lists;
+};
+
+/**
+ * @brief Caches of the current thread, one for each pool it has used.
+ *
+ */
+class synchronized_pool_caches {
+public:
+    synchronized_pool_caches() = default;
+
+    synchronized_pool_caches(const synchronized_pool_caches&)            = delete;
+    synchronized_pool_caches& operator=(const synchronized_pool_caches&) = delete;
+
+    ~synchronized_pool_caches() { exited() = true; }
+
+    /**
+     * @brief Caches of the current thread, or nullptr once they are destroyed at thread exit.
+     *
+     * Static objects of the main thread are destroyed after its thread-local ones, and may still
+     * free blocks.
+     */
+    static auto local() -> synchronized_pool_caches* {
+        if (exited()) [[unlikely]] {
+            return nullptr;
+        }
+        thread_local synchronized_pool_caches caches;
+        return &caches;
+    }
+
+    auto find(const std::shared_ptr<synchronized_pool_state>& state) -> synchronized_pool_cache& {
+        if (last_ != nullptr && last_->state == state) [[likely]] {
+            return *last_;
+        }
+        return find_slow(state);
+    }
+
+private:
+    auto find_slow(const std::shared_ptr<synchronized_pool_state>& state)
+        -> synchronized_pool_cache& {
+        // caches of destroyed pools are dropped here, giving their chunks back.
+        std::erase_if(caches_, [](const auto& cache) {
+            return !cache->state->alive.load(std::memory_order_relaxed);
+        });
+        auto iter = std::ranges::find_if(
+            caches_, [&state](const auto& cache) { return cache->state == state; });
+        if (iter == caches_.end()) {
+            caches_.emplace_back(std::make_unique<synchronized_pool_cache>(state));
+            iter = caches_.end() - 1;
+        }
+        last_ = iter->get();
+        return *last_;
+    }
+
+    // trivially destructible, so it is still readable after the caches are gone.
+    static auto exited() noexcept -> bool& {
+        thread_local bool flag{};
+        return flag;
+    }
+
+    std::vector<std::unique_ptr<synchronized_pool_cache>> caches_;
+    synchronized_pool_cache* last_{};
+};
+
 } // namespace internal
 
+/**
+ * @brief Memory pool shared by threads, caching blocks in each of them.
+ *
+ * Size classes are the same as `unsynchronized_pool`. Every thread keeps its own free lists for
+ * each pool, so most allocations and deallocations touch no shared state. A thread with too many
+ * cached blocks of a class, for example after freeing blocks allocated by others, returns a batch
+ * to central stacks, where other threads refill from. Chunks are only given back after the pool
+ * and every thread that used it are gone, or when such a thread next misses its cache.
+ * With a NUMA-local `pool_backing`, regions land on the node of the thread running out of blocks.
+ */
 class synchronized_pool {
     using self_type    = synchronized_pool;
     using memory_block = internal::memory_block;
+    using classes      = internal::size_classes;
 
 public:
     using shared_type = synchronized_pool*;
     using size_type   = std::size_t;
 
-    synchronized_pool(size_type block_size = internal::default_size) {}
+    synchronized_pool([[maybe_unused]] size_type block_size = internal::default_size)
+        : synchronized_pool(pool_backing{}) {}
+
+    explicit synchronized_pool(const pool_backing backing)
+        : state_(std::make_shared<internal::synchronized_pool_state>(backing)) {}
 
     synchronized_pool(const synchronized_pool&)            = delete;
     synchronized_pool& operator=(const synchronized_pool&) = delete;
     synchronized_pool(synchronized_pool&& that)            = delete;
     synchronized_pool& operator=(synchronized_pool&& that) = delete;
-    ~synchronized_pool() {}
+    ~synchronized_pool() { state_->alive.store(false, std::memory_order_relaxed); }
 
     auto get() -> shared_type { return this; }
 
     template <typename Ty>
     ALLOCATOR auto allocate(
         const size_type count = 1, const std::align_val_t align = std::align_val_t{ 16 }) -> Ty* {
-        return static_cast<Ty*>(operator new(sizeof(Ty) * count, align));
+        const auto size      = sizeof(Ty) * count;
+        const auto alignment = static_cast<size_type>(align);
+        if (!classes::fits(size, alignment)) [[unlikely]] {
+            return static_cast<Ty*>(state_->source.allocate_large(size, align));
+        }
+        const auto index = classes::index_of(size, alignment);
+        if (auto* const caches = internal::synchronized_pool_caches::local()) [[likely]] {
+            return static_cast<Ty*>(caches->find(state_).allocate(index));
+        }
+        // a cache living for this call only, it gives back what it does not hand out.
+        internal::synchronized_pool_cache cache{ state_ };
+        return static_cast<Ty*>(cache.allocate(index));
     }
 
     template <typename Ty>
     void deallocate(
         Ty* const ptr, const size_type count = 1,
         const std::align_val_t align = std::align_val_t{ 16 }) noexcept {
-        operator delete(ptr, align);
+        const auto size      = sizeof(Ty) * count;
+        const auto alignment = static_cast<size_type>(align);
+        if (!classes::fits(size, alignment)) [[unlikely]] {
+            state_->source.deallocate_large(static_cast<void*>(ptr), size, align);
+            return;
+        }
+        const auto index = classes::index_of(size, alignment);
+        if (auto* const caches = internal::synchronized_pool_caches::local()) [[likely]] {
+            caches->find(state_).deallocate(index, static_cast<void*>(ptr));
+            return;
+        }
+        // pushed straight onto the central stack.
+        internal::synchronized_pool_cache cache{ state_ };
+        cache.deallocate(index, static_cast<void*>(ptr));
     }
 
 private:
+    std::shared_ptr<internal::synchronized_pool_state> state_;
 };
 
+/**
+ * @brief Memory pool for a single thread, copies share the same pool.
+ *
+ * Small requests are served from power-of-two size classes. Each class keeps an intrusive list
+ * of free blocks, refilled by carving a whole chunk at once, so allocating and deallocating are
+ * a couple of pointer moves. Chunks are aligned to the largest class, so every block is aligned to
+ * its own size and any alignment up to the block size is honored. Requests larger than the
+ * largest class go to `operator new` directly. Memory of the chunks is given back when the last
+ * copy of the pool is destroyed. A `pool_backing` may ask for huge pages and NUMA placement.
+ */
 class unsynchronized_pool {
 public:
     using self_type = unsynchronized_pool;
@@ -69,39 +596,83 @@ public:
     using size_type = std::size_t;
 
     class pool {
-        using memory_block = ::atom::utils::internal::memory_block;
-
         friend class unsynchronized_pool;
 
-        pool() = default;
+        explicit pool(const pool_backing backing) noexcept : source_(backing) {}
 
-        static auto get() -> std::shared_ptr<pool>;
+        static auto get(const pool_backing backing) -> std::shared_ptr<pool> {
+            return std::shared_ptr<pool>(new pool(backing));
+        }
 
     public:
         using size_type = unsynchronized_pool::size_type;
 
+        constexpr static size_type min_block_size = internal::size_classes::min_block_size;
+        constexpr static size_type max_block_size = internal::size_classes::max_block_size;
+        constexpr static size_type chunk_size     = internal::size_classes::chunk_size;
+
+        pool(const pool&)            = delete;
+        pool(pool&&)                 = delete;
+        pool& operator=(const pool&) = delete;
+        pool& operator=(pool&&)      = delete;
+
+        ~pool() noexcept = default;
+
         template <typename Ty>
         ALLOCATOR auto allocate(
             const size_type count = 1, const std::align_val_t align = std::align_val_t{ 16 })
             -> Ty* {
-            // TODO: allocate impl
-            return operator new(sizeof(Ty) * count, align);
+            const auto size      = sizeof(Ty) * count;
+            const auto alignment = static_cast<size_type>(align);
+            if (!classes::fits(size, alignment)) [[unlikely]] {
+                return static_cast<Ty*>(source_.allocate_large(size, align));
+            }
+
+            const auto index = classes::index_of(size, alignment);
+            if (free_lists_[index] == nullptr) [[unlikely]] {
+                refill(index);
+            }
+            auto* const block  = free_lists_[index];
+            free_lists_[index] = block->next;
+            return static_cast<Ty*>(static_cast<void*>(block));
         }
 
         template <typename Ty>
         void deallocate(
             Ty* ptr, const size_type count = 1,
-            const std::align_val_t align = std::align_val_t{ 16 }) {
-            // TODO: deallocate impl
-            operator delete(ptr, sizeof(Ty) * count, align);
+            const std::align_val_t align = std::align_val_t{ 16 }) noexcept {
+            const auto size      = sizeof(Ty) * count;
+            const auto alignment = static_cast<size_type>(align);
+            if (!classes::fits(size, alignment)) [[unlikely]] {
+                source_.deallocate_large(static_cast<void*>(ptr), size, align);
+                return;
+            }
+
+            const auto index   = classes::index_of(size, alignment);
+            free_lists_[index] = ::new (static_cast<void*>(ptr))
+                free_block{ free_lists_[index], nullptr };
         }
 
     private:
-        std::map<size_type, std::stack<memory_block>> unused_blocks_;
-        std::map<size_type, std::map<default_id_t, memory_block>> using_blocks_;
+        using classes    = internal::size_classes;
+        using free_block = internal::free_block;
+
+        /**
+         * @brief Carve a new chunk into free blocks of the class, lowest address first.
+         *
+         */
+        void refill(const size_type index) {
+            free_lists_[index] = internal::carve_chunk(
+                source_.allocate_chunk(), classes::block_size(index), free_lists_[index]);
+        }
+
+        std::array<free_block*, classes::count> free_lists_{};
+        internal::chunk_source source_;
     };
 
-    unsynchronized_pool() : pool_(pool::get()) {}
+    unsynchronized_pool() : pool_(pool::get(pool_backing{})) {}
+
+    explicit unsynchronized_pool(const pool_backing backing) : pool_(pool::get(backing)) {}
 
     unsynchronized_pool(const unsynchronized_pool&)            = default;
     unsynchronized_pool& operator=(const unsynchronized_pool&) = default;
@@ -123,4 +694,348 @@ private:
     shared_type pool_;
 };
 
+/**
+ * @brief Memory pool for the nodes of a node-based container of `Ty`, copies share the same pool.
+ *
+ * Containers rebind their allocator to their node type, and may first allocate helper objects of
+ * other sizes. Single objects up to `max_slot_size` bytes are therefore served by slot lists of
+ * their size class, `slot_align` bytes apart, each an intrusive free list refilled one page-sized
+ * chunk at a time, so nodes allocated together sit next to each other. Arrays, larger or
+ * over-aligned objects, like the buckets of an unordered set, go to `operator new` directly.
+ * Chunks are given back when the last copy of the pool is destroyed.
+ * @tparam Mutex Lock taken by every allocation, `null_lock` for a single thread.
+ */
+template <typename Ty, typename Mutex = null_lock>
+class object_pool {
+public:
+    using self_type  = object_pool;
+    using value_type = Ty;
+    using size_type  = std::size_t;
+    class pool;
+    using shared_type = std::shared_ptr<pool>;
+
+    class pool {
+        friend class object_pool;
+
+        pool() = default;
+
+        static auto get() -> std::shared_ptr<pool> { return std::shared_ptr<pool>(new pool); }
+
+    public:
+        using size_type = object_pool::size_type;
+
+        constexpr static size_type chunk_size    = internal::default_size;
+        constexpr static size_type slot_align    = 16;
+        constexpr static size_type max_slot_size = 256;
+
+        pool(const pool&)            = delete;
+        pool(pool&&)                 = delete;
+        pool& operator=(const pool&) = delete;
+        pool& operator=(pool&&)      = delete;
+
+        ~pool() noexcept {
+            for (auto* const chunk : chunks_) {
+                operator delete(chunk, chunk_size, std::align_val_t{ slot_align });
+            }
+        }
+
+        template <typename Other>
+        ALLOCATOR auto allocate(
+            const size_type count = 1, const std::align_val_t align = std::align_val_t{ 16 })
+            -> Other* {
+            const auto size      = sizeof(Other) * count;
+            const auto alignment = static_cast<size_type>(align);
+            if (count != 1 || !slotted(size, alignment)) [[unlikely]] {
+                return static_cast<Other*>(operator new(size, align));
+            }
+
+            const auto index = class_of(size);
+            internal::unique_guard_t<Mutex> lock{ mutex_ };
+            if (free_[index] == nullptr) [[unlikely]] {
+                refill(index);
+            }
+            auto* const slot = free_[index];
+            free_[index]     = slot->next;
+            return static_cast<Other*>(static_cast<void*>(slot));
+        }
+
+        template <typename Other>
+        void deallocate(
+            Other* const ptr, const size_type count = 1,
+            const std::align_val_t align = std::align_val_t{ 16 }) noexcept {
+            const auto size      = sizeof(Other) * count;
+            const auto alignment = static_cast<size_type>(align);
+            if (count != 1 || !slotted(size, alignment)) [[unlikely]] {
+                operator delete(static_cast<void*>(ptr), size, align);
+                return;
+            }
+
+            const auto index = class_of(size);
+            internal::unique_guard_t<Mutex> lock{ mutex_ };
+            free_[index] = ::new (static_cast<void*>(ptr)) free_slot{ free_[index] };
+        }
+
+        /**
+         * @brief Size of the slots holding a single object of `size` bytes.
+         *
+         */
+        [[nodiscard]] constexpr static auto slot_size(const size_type size) noexcept
+            -> size_type {
+            return (class_of(size) + 1) * slot_align;
+        }
+
+    private:
+        struct free_slot {
+            free_slot* next;
+        };
+
+        constexpr static size_type class_count = max_slot_size / slot_align;
+
+        [[nodiscard]] constexpr static auto slotted(
+            const size_type size, const size_type alignment) noexcept -> bool {
+            return size <= max_slot_size && alignment <= slot_align;
+        }
+
+        [[nodiscard]] constexpr static auto class_of(const size_type size) noexcept -> size_type {
+            return (std::max(size, sizeof(free_slot)) - 1) / slot_align;
+        }
+
+        /**
+         * @brief Carve a new chunk into free slots of the class, lowest address first.
+         *
+         */
+        void refill(const size_type index) {
+            const auto slot  = (index + 1) * slot_align;
+            const auto bytes = chunk_size / slot * slot;
+            chunks_.reserve(chunks_.size() + 1);
+            auto* const chunk =
+                static_cast<std::byte*>(operator new(chunk_size, std::align_val_t{ slot_align }));
+            chunks_.emplace_back(chunk);
+
+            for (auto offset = bytes; offset != 0;) {
+                offset -= slot;
+                free_[index] = ::new (static_cast<void*>(chunk + offset)) free_slot{ free_[index] };
+            }
+        }
+
+        std::array<free_slot*, class_count> free_{};
+        std::vector<void*> chunks_;
+        [[no_unique_address]] Mutex mutex_;
+    };
+
+    object_pool() : pool_(pool::get()) {}
+
+    object_pool(const object_pool&)            = default;
+    object_pool& operator=(const object_pool&) = default;
+
+    object_pool(object_pool&& that) noexcept : pool_(std::move(that.pool_)) {}
+    object_pool& operator=(object_pool&& that) noexcept {
+        if (this != &that) {
+            pool_ = std::move(that.pool_);
+        }
+        return *this;
+    }
+
+    ~object_pool() = default;
+
+    auto get() -> shared_type { return pool_; }
+    auto get() const -> const shared_type { return pool_; }
+
+private:
+    shared_type pool_;
+};
+
+/**
+ * @brief Memory pool handing out memory by bumping a pointer, freeing nothing until reset.
+ *
+ * Made for scratch memory living as long as a frame or a task, and used by a single thread.
+ * Buffers are chained, each one at least twice as large as the previous one. Deallocating is a
+ * no-op, unless it is the latest allocation, which is rolled back so a growing vector can reuse its
+ * room. Memory is given back by `reset`, keeping the largest buffer, or `release`, keeping nothing
+ * but the initial buffer. Both cost nothing per allocation, only per buffer.
+ */
+class monotonic_pool {
+public:
+    using shared_type = monotonic_pool*;
+    using size_type   = std::size_t;
+
+    /**
+     * @brief Usage since construction or the latest `reset` or `release`.
+     *
+     */
+    struct statistics {
+        /// @brief Number of allocations.
+        size_type allocations;
+        /// @brief Bytes requested by the allocations, rolled back ones excluded.
+        size_type bytes_allocated;
+        /// @brief Most bytes allocated at once.
+        size_type peak_bytes;
+        /// @brief Bytes held in buffers, the initial buffer included.
+        size_type bytes_reserved;
+        /// @brief Number of buffers, the initial buffer included.
+        size_type buffers;
+    };
+
+    /**
+     * @brief Construct a pool whose first buffer is allocated at the first allocation.
+     *
+     * @param initial_size Size of the first buffer.
+     */
+    explicit monotonic_pool(const size_type initial_size = internal::default_size) noexcept
+        : next_size_(std::max<size_type>(initial_size, 2 * sizeof(buffer))) {}
+
+    /**
+     * @brief Construct a pool allocating from a buffer owned by the caller, for example an array
+     * on the stack, before going to the heap.
+     *
+     */
+    monotonic_pool(void* const buffer, const size_type size) noexcept
+        : initial_(static_cast<std::byte*>(buffer)), initial_size_(size),
+          current_(static_cast<std::byte*>(buffer)), end_(current_ + size),
+          next_size_(std::max<size_type>(size * 2, internal::default_size)) {
+        recount();
+    }
+
+    monotonic_pool(const monotonic_pool&)            = delete;
+    monotonic_pool(monotonic_pool&&)                 = delete;
+    monotonic_pool& operator=(const monotonic_pool&) = delete;
+    monotonic_pool& operator=(monotonic_pool&&)      = delete;
+
+    ~monotonic_pool() noexcept { free_buffers(buffers_); }
+
+    auto get() -> shared_type { return this; }
+
+    // not `ALLOCATOR`, the memory may be a buffer of the caller, reachable through its name.
+    template <typename Ty>
+    auto allocate(
+        const size_type count = 1, const std::align_val_t align = std::align_val_t{ 16 }) -> Ty* {
+        const auto size      = sizeof(Ty) * count;
+        const auto alignment = static_cast<size_type>(align);
+
+        auto* ptr = align_up(current_, alignment);
+        if (!fits(ptr, size)) [[unlikely]] {
+            grow(size, alignment);
+            ptr = align_up(current_, alignment);
+        }
+        last_    = ptr;
+        current_ = ptr + size;
+
+        ++stats_.allocations;
+        stats_.bytes_allocated += size;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_allocated);
+        return static_cast<Ty*>(static_cast<void*>(ptr));
+    }
+
+    template <typename Ty>
+    void deallocate(
+        Ty* const ptr, const size_type count = 1,
+        [[maybe_unused]] const std::align_val_t align = std::align_val_t{ 16 }) noexcept {
+        auto* const bytes = static_cast<std::byte*>(static_cast<void*>(ptr));
+        if (bytes == last_ && bytes + sizeof(Ty) * count == current_) {
+            current_ = last_;
+            last_    = nullptr;
+            stats_.bytes_allocated -= sizeof(Ty) * count;
+        }
+    }
+
+    /**
+     * @brief Forget every allocation and keep only the largest buffer for the next ones.
+     *
+     */
+    void reset() noexcept {
+        if (buffers_ != nullptr) {
+            free_buffers(buffers_->prev);
+            buffers_->prev = nullptr;
+            current_       = buffers_->data();
+            end_           = buffers_->end();
+        }
+        else {
+            current_ = initial_;
+            end_     = initial_ + initial_size_;
+        }
+        last_  = nullptr;
+        stats_ = {};
+        recount();
+    }
+
+    /**
+     * @brief Forget every allocation and free every buffer but the initial one.
+     *
+     */
+    void release() noexcept {
+        free_buffers(buffers_);
+        buffers_ = nullptr;
+        current_ = initial_;
+        end_     = initial_ + initial_size_;
+        last_    = nullptr;
+        stats_   = {};
+        recount();
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> statistics { return stats_; }
+
+private:
+    struct buffer {
+        buffer* prev;
+        size_type size;
+
+        auto data() noexcept -> std::byte* {
+            return reinterpret_cast<std::byte*>(this) + sizeof(buffer);
+        }
+
+        auto end() noexcept -> std::byte* { return reinterpret_cast<std::byte*>(this) + size; }
+    };
+
+    static auto align_up(std::byte* const ptr, const size_type alignment) noexcept -> std::byte* {
+        const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+        const auto aligned = (address + alignment - 1) & ~(alignment - 1);
+        return ptr == nullptr ? nullptr : ptr + (aligned - address);
+    }
+
+    [[nodiscard]] auto fits(const std::byte* const ptr, const size_type size) const noexcept
+        -> bool {
+        return ptr != nullptr && ptr <= end_ && size <= static_cast<size_type>(end_ - ptr);
+    }
+
+    static void free_buffers(buffer* head) noexcept {
+        while (head != nullptr) {
+            auto* const prev = head->prev;
+            operator delete(static_cast<void*>(head), head->size);
+            head = prev;
+        }
+    }
+
+    void grow(const size_type size, const size_type alignment) {
+        const auto needed = sizeof(buffer) + size + alignment;
+        const auto bytes  = std::max(next_size_, needed);
+
+        auto* const block = ::new (operator new(bytes)) buffer{ buffers_, bytes };
+        buffers_   = block;
+        current_   = block->data();
+        end_       = block->end();
+        next_size_ = bytes * 2;
+
+        ++stats_.buffers;
+        stats_.bytes_reserved += bytes;
+    }
+
+    void recount() noexcept {
+        stats_.buffers        = initial_ != nullptr ? 1 : 0;
+        stats_.bytes_reserved = initial_size_;
+        if (buffers_ != nullptr) {
+            ++stats_.buffers;
+            stats_.bytes_reserved += buffers_->size;
+        }
+    }
+
+    std::byte* initial_{};
+    size_type initial_size_{};
+    std::byte* current_{};
+    std::byte* end_{};
+    std::byte* last_{};
+    buffer* buffers_{};
+    size_type next_size_;
+    statistics stats_{};
+};
+
 } // namespace atom::utils
@@ -1,5 +1,7 @@
 #pragma once
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <new>
 #include <type_traits>
@@ -8,6 +10,7 @@
 #include "core.hpp"
 #include "core/langdef.hpp"
 #include "core/pair.hpp"
+#include "core/type_traits.hpp"
 #include "memory.hpp"
 #include "memory/allocator.hpp"
 #include "memory/destroyer.hpp"
@@ -55,18 +58,68 @@ constexpr auto wrap_destroyer(Destroyer destroyer) -> void (*)(void*) {
             return [](void* const ptr) { Destroyer{}(static_cast<Ty*>(ptr)); };
     }
     else {
-        static_assert(false);
+        static_assert(dependent_false_v<Destroyer>);
         return nullptr;
     }
 }
 
+/**
+ * @brief Room for a value inside the object holding it.
+ *
+ */
+template <typename Ty>
+struct inline_buffer {
+    // NOLINTBEGIN(cppcoreguidelines-avoid-c-arrays, cppcoreguidelines-pro-type-reinterpret-cast)
+    alignas(Ty) std::byte bytes[sizeof(Ty)];
+
+    auto get() noexcept -> Ty* { return reinterpret_cast<Ty*>(bytes); }
+    auto get() const noexcept -> const Ty* { return reinterpret_cast<const Ty*>(bytes); }
+    // NOLINTEND(cppcoreguidelines-avoid-c-arrays, cppcoreguidelines-pro-type-reinterpret-cast)
+};
+
+/**
+ * @brief Where a storage keeps its value: a buffer inside it and whether the value is there.
+ *
+ * The address of the value is the address of the buffer, so no pointer is stored or loaded.
+ */
+template <typename Ty, bool Inline>
+struct storage_slot {
+    // ahead of the buffer, so checking it reads the line that the front of the value is on.
+    bool engaged{};
+    inline_buffer<Ty> buffer;
+
+    [[nodiscard]] auto location() noexcept -> Ty* { return buffer.get(); }
+
+    [[nodiscard]] auto data() noexcept -> Ty* { return std::launder(buffer.get()); }
+
+    [[nodiscard]] auto data() const noexcept -> const Ty* { return std::launder(buffer.get()); }
+
+    [[nodiscard]] auto has_value() const noexcept -> bool { return engaged; }
+};
+
+/**
+ * @brief Where a storage keeps its value: allocated memory, null when it is empty.
+ *
+ */
+template <typename Ty>
+struct storage_slot<Ty, false> {
+    Ty* ptr{};
+
+    [[nodiscard]] auto data() const noexcept -> Ty* { return ptr; }
+
+    [[nodiscard]] auto has_value() const noexcept -> bool { return ptr != nullptr; }
+};
+
 } // namespace internal
 
 /**
  * @brief Lazy storage.
  * Initialize on Get, Copy on Write.
+ *
+ * A value whose size is at most `InlineSize` and which is nothrow movable lives inside the storage
+ * itself, and the allocator is never used. Moving such a storage moves the value.
  */
-template <typename Ty, typename Allocator>
+template <typename Ty, typename Allocator, std::size_t InlineSize>
 class unique_storage final : public basic_storage {
     template <typename Target>
     using allocator_t = typename rebind_allocator<Allocator>::template to<Target>::type;
@@ -85,7 +138,15 @@ public:
     static_assert(sizeof(Ty), "Can't suit for incompleted type");
     static_assert(!std::is_const_v<Ty>);
 
-    constexpr unique_storage() noexcept(std::is_nothrow_default_constructible_v<alty>) = default;
+    /**
+     * @brief Whether the value lives inside the storage.
+     *
+     */
+    constexpr static bool is_inline =
+        sizeof(Ty) <= InlineSize && std::is_nothrow_move_constructible_v<Ty>;
+
+    constexpr unique_storage() noexcept(std::is_nothrow_default_constructible_v<alty>)
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), allocator_type{}) {}
 
     /*
      * construct at once
@@ -109,7 +170,7 @@ public:
     _CONSTEXPR20 unique_storage(
         std::allocator_arg_t, const Al& al, construct_at_once_t, with_destroyer_t,
         Destroyer& destroyer, Args&&... args)
-        : pair_(internal::wrap_destroyer<Ty>(destroyer), al), val_(nullptr) {
+        : pair_(internal::wrap_destroyer<Ty>(destroyer), al) {
         allocate_and_construct(std::forward<Args>(args)...);
     }
 
@@ -121,7 +182,7 @@ public:
     // _CONSTEXPR20 unique_storage(
     //     std::allocator_arg_t, const Al& al, construct_at_once_t, Destroyer& destroyer,
     //     Args&&... args)
-    //     : pair_(internal::wrap_destroyer<Ty>(destroyer), al), val_(nullptr) {
+    //     : pair_(internal::wrap_destroyer<Ty>(destroyer), al) {
     //     allocate_and_construct(std::forward<Args>(args)...);
     // }
 
@@ -139,28 +200,24 @@ public:
         typename = std::enable_if_t<std::is_constructible_v<value_type, Args...>>>
     _CONSTEXPR20 unique_storage(
         std::allocator_arg_t, const Al& al, construct_at_once_t, Args&&... args)
-        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), al), val_(nullptr) {
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), al) {
         allocate_and_construct(std::forward<Args>(args)...);
     }
 
     _CONSTEXPR20 unique_storage(construct_at_once_t)
-        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), {}), val_(nullptr) {
-        auto& alloc     = pair_.second();
-        auto* const ptr = alloc.allocate(1);
-        alty_traits::construct(alloc, val_);
-        val_ = std::launder(ptr);
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), {}) {
+        allocate_and_construct();
     }
 
     template <typename... Args>
     _CONSTEXPR20 unique_storage(construct_at_once_t, Args&&... args)
-        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), {}), val_(nullptr) {
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), {}) {
         allocate_and_construct(std::forward<Args>(args)...);
     }
 
     template <typename... Args, typename = std::enable_if_t<std::is_constructible_v<Ty, Args...>>>
     _CONSTEXPR20 explicit unique_storage(Args&&... args)
-        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), allocator_type{}),
-          val_(nullptr) {
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), allocator_type{}) {
         allocate_and_construct(std::forward<Args>(args)...);
     }
 
@@ -181,24 +238,25 @@ public:
     _CONSTEXPR20 unique_storage(
         std::allocator_arg_t, const Al& al, with_destroyer_t,
         Destroyer& destroyer) noexcept(std::is_nothrow_constructible_v<allocator_type, Al>)
-        : pair_(internal::wrap_destroyer<Ty>(destroyer), al), val_(nullptr) {}
+        : pair_(internal::wrap_destroyer<Ty>(destroyer), al) {}
 
     template <typename Al, typename Destroyer>
     _CONSTEXPR20 unique_storage(std::allocator_arg_t, const Al& al, Destroyer& destroyer) noexcept(
         std::is_nothrow_constructible_v<allocator_type, Al>)
-        : pair_(internal::wrap_destroyer<Ty>(destroyer), al), val_(nullptr) {}
+        : pair_(internal::wrap_destroyer<Ty>(destroyer), al) {}
 
     template <typename Al>
     _CONSTEXPR20 unique_storage(std::allocator_arg_t, const Al& al)
-        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), al), val_(nullptr) {}
+        : pair_(internal::wrap_destroyer<Ty>(default_destroyer<Ty>{}), al) {}
 
     template <typename Al>
     _CONSTEXPR20 unique_storage(Al& al) : unique_storage(std::allocator_arg, al) {}
 
     constexpr unique_storage(const unique_storage& that) = delete;
 
-    constexpr unique_storage(unique_storage&& that) noexcept
-        : pair_(std::move(that.pair_)), val_(std::exchange(that.val_, nullptr)) {}
+    constexpr unique_storage(unique_storage&& that) noexcept : pair_(std::move(that.pair_)) {
+        take(that);
+    }
 
     template <typename Al>
     constexpr unique_storage(std::allocator_arg_t, const Al& al, unique_storage&& that) noexcept
@@ -208,8 +266,9 @@ public:
 
     constexpr unique_storage& operator=(unique_storage&& that) noexcept {
         if (this != &that) {
+            release();
             pair_ = std::move(that.pair_);
-            val_  = std::exchange(that.val_, nullptr);
+            take(that);
         }
 
         return *this;
@@ -217,23 +276,25 @@ public:
 
     ~unique_storage() noexcept(std::is_nothrow_destructible_v<Ty>) override { release(); }
 
-    auto raw() noexcept -> void* override { return static_cast<void*>(val_); }
+    auto raw() noexcept -> void* override { return static_cast<void*>(get()); }
     [[nodiscard]] auto raw() const noexcept -> const void* override {
-        return static_cast<void*>(val_);
+        return static_cast<const void*>(get());
     }
 
-    constexpr explicit operator bool() const noexcept override { return val_; }
+    constexpr explicit operator bool() const noexcept override { return slot_.has_value(); }
 
-    constexpr auto& operator*() noexcept { return *val_; }
-    constexpr const auto& operator*() const noexcept { return *val_; }
+    constexpr auto& operator*() noexcept { return *slot_.data(); }
+    constexpr const auto& operator*() const noexcept { return *slot_.data(); }
 
-    constexpr auto get() noexcept -> Ty* { return val_; }
-    [[nodiscard]] constexpr auto get() const noexcept -> const Ty* { return val_; }
+    constexpr auto get() noexcept -> Ty* { return slot_.has_value() ? slot_.data() : nullptr; }
+    [[nodiscard]] constexpr auto get() const noexcept -> const Ty* {
+        return slot_.has_value() ? slot_.data() : nullptr;
+    }
 
     template <typename Val, typename = std::enable_if_t<std::is_convertible_v<Ty, Val>>>
     unique_storage& operator=(Val&& val) {
-        if (val_) {
-            *val_ = std::forward<Val>(val);
+        if (slot_.has_value()) {
+            *slot_.data() = std::forward<Val>(val);
         }
         else {
             allocate_and_construct(std::forward<Val>(val));
@@ -246,71 +307,174 @@ public:
         typename... Args,
         typename = std::enable_if_t<sizeof...(Args) != 1 && std::is_constructible_v<Ty, Args...>>>
     _CONSTEXPR20 unique_storage& operator=(Args&&... args) {
-        if (val_) {
-            *val_ = Ty(std::forward<Args>(args)...);
+        if (slot_.has_value()) {
+            *slot_.data() = Ty(std::forward<Args>(args)...);
         }
         else {
-            auto& alloc     = pair_.second();
-            auto* const ptr = alloc.allocate(1);
-            alty_traits::construct(ptr, std::forward<Args>(args)...);
-            val_ = std::launder(ptr);
+            allocate_and_construct(std::forward<Args>(args)...);
         }
+
+        return *this;
     }
 
-    constexpr auto operator->() noexcept -> Ty* { return val_; }
-    [[nodiscard]] constexpr auto operator->() const noexcept -> const Ty* { return val_; }
+    constexpr auto operator->() noexcept -> Ty* { return slot_.data(); }
+    [[nodiscard]] constexpr auto operator->() const noexcept -> const Ty* { return slot_.data(); }
 
-    constexpr void reset() {
-        if (val_) [[likely]] {
-            pair_.first()(static_cast<void*>(val_));
-            pair_.second().deallocate(val_, 1);
-            val_ = nullptr;
-        }
-    }
+    constexpr void reset() { release(); }
 
     constexpr void release() {
-        if (val_) [[likely]] {
-            pair_.first()(static_cast<void*>(val_));
-            pair_.second().deallocate(val_, 1);
-            val_ = nullptr;
+        if (slot_.has_value()) [[likely]] {
+            pair_.first()(static_cast<void*>(slot_.data()));
+            if constexpr (is_inline) {
+                slot_.engaged = false;
+            }
+            else {
+                pair_.second().deallocate(std::exchange(slot_.ptr, nullptr), 1);
+            }
         }
     }
 
 private:
     template <typename... Args>
     _CONSTEXPR20 void allocate_and_construct(Args&&... args) {
-        auto& alloc     = pair_.second();
-        auto* const ptr = alloc.allocate(1);
-        alty_traits::construct(alloc, ptr, std::forward<Args>(args)...);
-        val_ = std::launder(ptr);
+        if constexpr (is_inline) {
+            std::construct_at(slot_.location(), std::forward<Args>(args)...);
+            slot_.engaged = true;
+        }
+        else {
+            auto& alloc     = pair_.second();
+            auto* const ptr = alloc.allocate(1);
+            alty_traits::construct(alloc, ptr, std::forward<Args>(args)...);
+            slot_.ptr = std::launder(ptr);
+        }
+    }
+
+    /**
+     * @brief Take the value of another storage, whose destroyer is already ours.
+     *
+     */
+    constexpr void take(unique_storage& that) noexcept {
+        if constexpr (is_inline) {
+            if (that.slot_.has_value()) {
+                std::construct_at(slot_.location(), std::move(*that.slot_.data()));
+                slot_.engaged = true;
+                pair_.first()(static_cast<void*>(that.slot_.data()));
+                that.slot_.engaged = false;
+            }
+        }
+        else {
+            slot_.ptr = std::exchange(that.slot_.ptr, nullptr);
+        }
     }
 
     compressed_pair<void (*)(void*), allocator_type> pair_;
-    Ty* val_{};
+    internal::storage_slot<Ty, is_inline> slot_;
 };
 
+/**
+ * @brief Reference count shared between threads, the default of `shared_storage`.
+ *
+ */
+struct atomic_refcount {
+    using value_type = std::uint32_t;
+
+    explicit atomic_refcount(const value_type count) noexcept : count_(count) {}
+
+    void increment() noexcept { count_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Drop a reference.
+     *
+     * @return Whether it was the last one.
+     */
+    auto decrement() noexcept -> bool {
+        return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    [[nodiscard]] auto load() const noexcept -> value_type {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<value_type> count_;
+};
+
+/**
+ * @brief Reference count without atomic instructions, for storages whose copies never leave the
+ * thread that made them.
+ *
+ */
+struct plain_refcount {
+    using value_type = std::uint32_t;
+
+    explicit plain_refcount(const value_type count) noexcept : count_(count) {}
+
+    void increment() noexcept { ++count_; }
+
+    auto decrement() noexcept -> bool { return --count_ == 0; }
+
+    [[nodiscard]] auto load() const noexcept -> value_type { return count_; }
+
+private:
+    value_type count_;
+};
+
+namespace internal {
+
+/**
+ * @brief Control block of a `shared_storage`.
+ *
+ */
+template <typename RefCount>
+struct shared_header {
+    explicit shared_header(const bool inplace) noexcept : count(1), inplace(inplace) {}
+
+    RefCount count;
+    // whether the value follows the header in the same allocation.
+    bool inplace;
+};
+
+/**
+ * @brief Control block followed by the value it counts.
+ *
+ */
+template <typename Ty, typename RefCount>
+struct shared_block : shared_header<RefCount> {
+    shared_block() noexcept : shared_header<RefCount>(true) {}
+
+    inline_buffer<Ty> buffer;
+};
+
+} // namespace internal
+
 /**
  * @brief Shared lazy storage.
  * Initialize on Get, Copy on Write.
+ *
+ * A value constructed by the storage shares a single allocation with its reference count, while an
+ * adopted pointer gets a count of its own. `plain_refcount` takes the atomic instructions off
+ * copies and destruction when every copy stays on one thread.
  */
-template <typename Ty, typename Allocator>
+template <typename Ty, typename Allocator, typename RefCount>
 class shared_storage final : public basic_storage {
     template <typename T>
     using allocator_t = typename rebind_allocator<Allocator>::template to<T>::type;
     using alty        = allocator_t<Ty>;
     using alty_traits = std::allocator_traits<alty>;
 
+    using header_type = internal::shared_header<RefCount>;
+    using block_type  = internal::shared_block<Ty, RefCount>;
+
 public:
-    using meta_count_type = uint32_t;
-    using count_type      = std::atomic<meta_count_type>;
+    using meta_count_type = typename RefCount::value_type;
+    using count_type      = RefCount;
 
-    using value_type           = Ty;
-    using allocator_type       = alty;
-    using count_allocator_type = typename Allocator::template rebind_t<count_type>;
-    using pointer              = typename alty_traits::pointer;
-    using const_pointer        = typename alty_traits::const_pointer;
-    using reference            = Ty&;
-    using const_reference      = const Ty&;
+    using value_type      = Ty;
+    using allocator_type  = alty;
+    using pointer         = typename alty_traits::pointer;
+    using const_pointer   = typename alty_traits::const_pointer;
+    using reference       = Ty&;
+    using const_reference = const Ty&;
 
     using destroyer_type = void (*)(void*);
 
@@ -322,21 +486,9 @@ public:
     // with ptr
     template <typename T>
     constexpr explicit shared_storage(T* ptr)
-        : pair_(ptr, allocator_type{}),
+        : pair_(nullptr, allocator_type{}),
           control_pair_(nullptr, internal::wrap_destroyer<Ty>(default_destroyer<Ty>{})) {
-        auto count_allocator = count_allocator_type{};
-        count_type* count    = nullptr;
-        try {
-            count = count_allocator.allocate();
-            ::new (count) count_type(1);
-            control_pair_.first() = std::launder(count);
-        }
-        catch (...) {
-            if (count) {
-                count->~count_type();
-            }
-            throw;
-        }
+        adopt(ptr);
     }
 
     // only allocator
@@ -353,31 +505,17 @@ public:
     // with ptr & allocator
     template <typename T>
     constexpr explicit shared_storage(T* ptr, const Allocator& allocator)
-        : pair_(ptr, allocator),
+        : pair_(nullptr, allocator),
           control_pair_(nullptr, internal::wrap_destroyer<Ty>(default_destroyer<Ty>{})) {
-        auto count_allocator = count_allocator_type{ allocator };
-        count_type* count    = nullptr;
-        try {
-            count = count_allocator.allocate();
-            ::new (count) count_type(1);
-            control_pair_.first() = std::launder(count);
-        }
-        catch (...) {
-            if (count) {
-                count->~count_type();
-                count_allocator.deallocate(count);
-            }
-            throw;
-        }
+        adopt(ptr);
     }
 
     // ptr & destroyer
     template <typename Destroyer = default_destroyer<Ty>>
-    constexpr explicit shared_storage(const Ty* ptr, with_destroyer_t, Destroyer destroyer)
-        : pair_(ptr, allocator_type{}),
-          control_pair_(
-              count_allocator_type().allocate(), internal::wrap_destroyer<Ty>(destroyer)) {
-        control_pair_.first()->store(1, std::memory_order_release);
+    constexpr explicit shared_storage(Ty* ptr, with_destroyer_t, Destroyer destroyer)
+        : pair_(nullptr, allocator_type{}),
+          control_pair_(nullptr, internal::wrap_destroyer<Ty>(destroyer)) {
+        adopt(ptr);
     }
 
     // allocator & destroyer
@@ -389,120 +527,39 @@ public:
     // ptr, allocator & destroyer
     template <typename T, typename Destroyer = default_destroyer<Ty>>
     constexpr explicit shared_storage(T* ptr, const Allocator& allocator, Destroyer destroyer)
-        : pair_(ptr, allocator),
-          control_pair_(count_allocator_type(allocator), internal::wrap_destroyer<Ty>(destroyer)) {}
+        : pair_(nullptr, allocator),
+          control_pair_(nullptr, internal::wrap_destroyer<Ty>(destroyer)) {
+        adopt(ptr);
+    }
 
     // arguments
     template <typename... Args>
-    requires std::is_constructible_v<Ty, Args...>
+    requires std::is_constructible_v<Ty, Args...> &&
+             (!std::is_same_v<std::remove_cvref_t<Args>, shared_storage> && ...)
     explicit shared_storage(Args&&... args)
         : pair_(nullptr, allocator_type{}),
           control_pair_(nullptr, internal::wrap_destroyer<Ty>(default_destroyer<Ty>{})) {
-        Ty* ptr = nullptr;
-        try {
-            ptr = pair_.second().allocate(1);
-            ::new (ptr) Ty(std::forward<Args>(args)...);
-            pair_.first() = std::launder(ptr);
-
-            count_type* count    = nullptr;
-            auto count_allocator = count_allocator_type{ pair_.second() }.allocate();
-            try {
-                count = count_allocator.allocate();
-                ::new (count) count_type(1);
-                control_pair_.first() = std::launder(count);
-            }
-            catch (...) {
-                if (count) {
-                    count_allocator.deallocate(count, 1);
-                }
-                throw;
-            }
-        }
-        catch (...) {
-            if (ptr) {
-                ptr->~Ty();
-                pair_.second().deallocate(ptr, 1);
-                if (pair_.first()) {
-                    pair_.first() = nullptr;
-                }
-            }
-            throw;
-        }
+        emplace(std::forward<Args>(args)...);
     }
 
+    // allocator & arguments
     template <typename... Args>
     requires std::is_constructible_v<Ty, Args...>
-    constexpr explicit shared_storage(Args&&... args, const Allocator& allocator)
+    explicit shared_storage(
+        std::allocator_arg_t, const Allocator& allocator, construct_at_once_t, Args&&... args)
         : pair_(nullptr, allocator),
-          control_pair_(nullptr, internal::wrap_destroyer<Ty>(default_destroyer<Ty>())) {
-        Ty* ptr = nullptr;
-        try {
-            ptr = pair_.second().allocate();
-            ::new (ptr) Ty(std::forward<Args>(args)...);
-            pair_.first() = std::launder(ptr);
-
-            count_type* count    = nullptr;
-            auto count_allocator = count_allocator_type{ pair_.second() }.allocate();
-            try {
-                count = count_allocator.allocate(1);
-                ::new (count) count_type(1);
-                control_pair_.first() = std::launder(count);
-            }
-            catch (...) {
-                if (count) {
-                    count_allocator.deallocate(count, 1);
-                }
-                throw;
-            }
-        }
-        catch (...) {
-            if (ptr) {
-                ptr->~Ty();
-                pair_.second().deallocate(ptr, 1);
-                if (pair_.first()) {
-                    pair_.first() = nullptr;
-                }
-            }
-            throw;
-        }
+          control_pair_(nullptr, internal::wrap_destroyer<Ty>(default_destroyer<Ty>{})) {
+        emplace(std::forward<Args>(args)...);
     }
 
-    template <typename... Args, typename Destroyer = default_destroyer<Ty>>
+    // destroyer & arguments
+    template <typename Destroyer, typename... Args>
     requires std::is_constructible_v<Ty, Args...>
-    constexpr explicit shared_storage(Args&&... args, with_destroyer_t, Destroyer destroyer)
+    explicit shared_storage(
+        construct_at_once_t, with_destroyer_t, Destroyer destroyer, Args&&... args)
         : pair_(nullptr, allocator_type{}),
           control_pair_(nullptr, internal::wrap_destroyer<Ty>(destroyer)) {
-        Ty* ptr = nullptr;
-        try {
-            ptr = pair_.second().allocate(1);
-            ::new (ptr) Ty(std::forward<Args>(args)...);
-            pair_.first() = std::launder(ptr);
-
-            count_type* count    = nullptr;
-            auto count_allocator = count_allocator_type{ pair_.second() };
-            try {
-                count = count_allocator.allocate(1);
-                ::new (count) count_type(1);
-                // noexcept
-                control_pair_.first() = std::launder(count);
-            }
-            catch (...) {
-                if (count) {
-                    count_allocator.deallocate(count);
-                    count = nullptr;
-                }
-                throw;
-            }
-        }
-        catch (...) {
-            if (ptr) {
-                pair_.second().deallocate(ptr);
-                if (pair_.first()) {
-                    pair_.first() = nullptr;
-                }
-            }
-            throw;
-        }
+        emplace(std::forward<Args>(args)...);
     }
 
     shared_storage(const shared_storage& that) noexcept
@@ -511,18 +568,11 @@ public:
     }
 
     shared_storage(shared_storage&& that) noexcept
-        : pair_(std::move(that.pair_)), control_pair_(std::move(that.control_pair_)) {}
-
-    template <typename T>
-    explicit shared_storage(const shared_storage<T, Allocator>& that) noexcept
         : pair_(that.pair_), control_pair_(that.control_pair_) {
-        inc();
+        that.pair_.first()         = nullptr;
+        that.control_pair_.first() = nullptr;
     }
 
-    template <typename T>
-    explicit shared_storage(shared_storage<T, Allocator>&& that) noexcept
-        : pair_(std::move(that.pair_)), control_pair_(std::move(that.control_pair_)) {}
-
     shared_storage& operator=(const shared_storage& that) noexcept {
         if (this != &that) {
             dec();
@@ -537,32 +587,15 @@ public:
     shared_storage& operator=(shared_storage&& that) noexcept {
         if (this != &that) {
             dec();
-            pair_         = std::move(that.pair_);
-            control_pair_ = std::move(that.control_pair_);
+            pair_                      = that.pair_;
+            control_pair_              = that.control_pair_;
+            that.pair_.first()         = nullptr;
+            that.control_pair_.first() = nullptr;
         }
 
         return *this;
     }
 
-    template <typename T>
-    shared_storage& operator=(const shared_storage<T, Allocator>& that) noexcept {
-        dec();
-        pair_         = that.pair_;
-        control_pair_ = that.control_pair_;
-        inc();
-
-        return *this;
-    }
-
-    template <typename T>
-    shared_storage& operator=(shared_storage<T, Allocator>&& that) noexcept {
-        dec();
-        pair_         = std::move(that.pair_);
-        control_pair_ = std::move(that.control_pair_);
-
-        return *this;
-    }
-
     ~shared_storage() override { dec(); }
 
     auto raw() noexcept -> void* override { return static_cast<void*>(pair_.first()); }
@@ -571,29 +604,22 @@ public:
     }
 
     template <typename Val>
+    requires(!std::is_same_v<std::remove_cvref_t<Val>, shared_storage>)
     shared_storage& operator=(Val&& val) {
         static_assert(std::is_constructible_v<Ty, Val> || std::is_default_constructible_v<Ty>);
 
-        auto& val_   = pair_.first();
-        auto& count_ = control_pair_.first();
-
-        if (count_ && count_->load() == 1) {
-            *val_ = std::forward<Val>(val);
+        if (count() == 1) {
+            *pair_.first() = std::forward<Val>(val);
         }
         else {
-            val_ = pair_.second().allocate();
+            dec();
             if constexpr (std::is_constructible_v<Ty, Val>) {
-                ::new (val_) Ty(std::forward<Val>(val));
-                val_ = std::launder(val_);
+                emplace(std::forward<Val>(val));
             }
-            else if constexpr (std::is_default_constructible_v<Ty>) {
-                ::new (val_) Ty();
-                val_  = std::launder(val_);
-                *val_ = std::forward<Val>(val);
+            else {
+                emplace();
+                *pair_.first() = std::forward<Val>(val);
             }
-            count_ = count_allocator_type{ pair_.second() }.allocate();
-            ::new (count_) count_type(1);
-            count_ = std::launder(count_);
         }
 
         return *this;
@@ -604,51 +630,85 @@ public:
     auto get() noexcept -> Ty* { return pair_.first(); }
     auto get() const noexcept -> const Ty* { return pair_.first(); }
 
-    template <typename T = void>
+    template <typename T = Ty>
     void reset(T* ptr = nullptr) {
         dec();
-        pair_.first()         = ptr;
-        control_pair_.first() = ptr ? ::new count_type(1) : nullptr;
+        adopt(ptr);
     }
 
-    void release() {
-        dec();
-        pair_.first()         = nullptr;
-        control_pair_.first() = nullptr;
-    }
+    void release() noexcept { dec(); }
 
-    [[nodiscard]] auto count() const noexcept {
-        return control_pair_.first()->load(std::memory_order_relaxed);
+    [[nodiscard]] auto count() const noexcept -> meta_count_type {
+        return control_pair_.first() ? control_pair_.first()->count.load() : meta_count_type{};
     }
 
 private:
-    inline constexpr void inc() {
-        if (control_pair_.first()) {
-            control_pair_.first()->fetch_add(1, std::memory_order_relaxed);
+    /**
+     * @brief Take ownership of a pointer from the allocator, destroying it if no count could be
+     * allocated.
+     *
+     */
+    template <typename T>
+    void adopt(T* ptr) {
+        if (ptr == nullptr) {
+            return;
         }
+
+        auto alloc = allocator_t<header_type>{ pair_.second() };
+        try {
+            control_pair_.first() = std::construct_at(alloc.allocate(1), false);
+        }
+        catch (...) {
+            control_pair_.second()(static_cast<void*>(ptr));
+            pair_.second().deallocate(ptr, 1);
+            throw;
+        }
+        pair_.first() = ptr;
     }
 
-    inline constexpr void dec() {
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        auto alloc        = allocator_t<block_type>{ pair_.second() };
+        auto* const block = std::construct_at(alloc.allocate(1));
+        try {
+            pair_.first() = std::construct_at(block->buffer.get(), std::forward<Args>(args)...);
+        }
+        catch (...) {
+            std::destroy_at(block);
+            alloc.deallocate(block, 1);
+            throw;
+        }
+        control_pair_.first() = block;
+    }
+
+    void inc() noexcept {
         if (control_pair_.first()) {
-            meta_count_type expected = 1;
-            if (control_pair_.first()->load(std::memory_order_acquire) == 1 &&
-                control_pair_.first()->compare_exchange_strong(
-                    expected, 0, std::memory_order_acq_rel)) {
-                control_pair_.second()(static_cast<void*>(pair_.first()));
-                pair_.second().deallocate(pair_.first());
-                pair_.first() = nullptr;
-                control_pair_.first()->~count_type();
-                count_allocator_type{ pair_.second() }.deallocate(control_pair_.first());
-                control_pair_.first() = nullptr;
-            }
-            else {
-                control_pair_.first()->fetch_sub(1, std::memory_order_release);
-            }
+            control_pair_.first()->count.increment();
+        }
+    }
+
+    void dec() noexcept {
+        auto* const header = std::exchange(control_pair_.first(), nullptr);
+        auto* const ptr    = std::exchange(pair_.first(), nullptr);
+        if (header == nullptr || !header->count.decrement()) {
+            return;
+        }
+
+        control_pair_.second()(static_cast<void*>(ptr));
+        if (header->inplace) {
+            auto* const block = static_cast<block_type*>(header);
+            std::destroy_at(block);
+            allocator_t<block_type>{ pair_.second() }.deallocate(block, 1);
+        }
+        else {
+            pair_.second().deallocate(ptr, 1);
+            std::destroy_at(header);
+            allocator_t<header_type>{ pair_.second() }.deallocate(header, 1);
         }
     }
 
     compressed_pair<Ty*, allocator_type> pair_;
-    compressed_pair<count_type*, destroyer_type> control_pair_;
+    compressed_pair<header_type*, destroyer_type> control_pair_;
 };
 
 } // namespace atom::utils
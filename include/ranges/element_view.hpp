@@ -6,6 +6,7 @@
 #include "concepts/type.hpp"
 #include "core/pipeline.hpp"
 #include "core/tuple.hpp"
+#include "core/type_traits.hpp"
 #include "ranges.hpp"
 
 namespace atom::utils::ranges {
@@ -30,7 +31,7 @@ struct element_iterator {
             return uniget<Index>(*iter_);
         }
         else {
-            static_assert(false, "No suitable method to get the value.");
+            static_assert(dependent_false_v<Rng>, "No suitable method to get the value.");
         }
     }
 
@@ -40,7 +41,7 @@ struct element_iterator {
             return uniget<Index>(*iter_);
         }
         else {
-            static_assert(false, "No suitable method to get the value.");
+            static_assert(dependent_false_v<Rng>, "No suitable method to get the value.");
         }
     }
 
@@ -184,7 +185,7 @@ public:
             return element_iterator<Vw, Index, true>(std::ranges::end(range_));
         }
         else {
-            static_assert(false, "No suitable method to get a const iterator");
+            static_assert(dependent_false_v<Vw>, "No suitable method to get a const iterator");
         }
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <concepts>
+#include <shared_mutex>
 #include "concepts/allocator.hpp"
 #include "core/pair.hpp"
 #include "memory.hpp"
@@ -10,27 +11,75 @@ namespace atom::utils {
 
 constexpr std::size_t k_default_page_size = 32;
 
+/**
+ * @brief Sparse set storing its values contiguously.
+ *
+ * @tparam Mutex Lock guarding every operation. Use `null_lock` for instances that never cross
+ * threads, `spin_lock` for short critical sections, or `std::shared_mutex` for concurrent readers.
+ * @tparam InlinePages Keep pages inside the page directory rather than allocating each of them,
+ * saving an indirection on every lookup at the cost of a whole page for every empty entry: pages
+ * are no longer lazy, one key at 10'000'000 holds about 88 MiB rather than 12 MiB.
+ */
 template <
     std::unsigned_integral Ty, typename Alloc = std::allocator<Ty>,
-    std::size_t = k_default_page_size>
+    std::size_t = k_default_page_size, typename Mutex = std::shared_mutex,
+    bool InlinePages = false>
 class dense_set;
 
 #if _HAS_CXX20
+/**
+ * @brief Sparse map storing its key-value pairs contiguously.
+ *
+ * @tparam Mutex Lock guarding every operation, see `dense_set`.
+ * @tparam VersionBits Number of high key bits holding a version, see `versioned_key_traits`.
+ * Zero disables versioning.
+ * @tparam InlinePages Keep pages inside the page directory, see `dense_set`.
+ */
 template <
     std::unsigned_integral Kty, typename Ty, typename Alloc = std::allocator<std::pair<Kty, Ty>>,
-    std::size_t = k_default_page_size>
+    std::size_t = k_default_page_size, typename Mutex = std::shared_mutex,
+    std::size_t VersionBits = 0, bool InlinePages = false>
 #elif _HAS_CXX17
 template <
     typename Kty, typename Ty, typename Alloc, std::size_t PageSize,
+    typename Mutex = std::shared_mutex, std::size_t VersionBits = 0, bool InlinePages = false,
     typename = std::enable_if_t<std::is_integral_v<Kty> && std::is_unsigned_v<Kty>>>
 #endif
 class dense_map;
 
+/**
+ * @brief Sparse map storing its keys and values in separate contiguous arrays.
+ *
+ */
+template <
+    std::unsigned_integral Kty, typename Ty, typename Alloc = std::allocator<std::pair<Kty, Ty>>,
+    std::size_t = k_default_page_size, typename Mutex = std::shared_mutex>
+class soa_dense_map;
+
+template <
+    std::unsigned_integral Kty, typename Ty, typename Alloc = std::allocator<std::pair<Kty, Ty>>,
+    std::size_t = k_default_page_size>
+class concurrent_dense_map;
+
+template <typename... Maps>
+class dense_group;
+
+template <typename... Containers>
+class join_view;
+
 #if __has_include(<memory_resource>)
 namespace pmr {
 
-template <std::unsigned_integral Key, typename Val, std::size_t size = k_default_page_size>
-using dense_map = dense_map<Key, Val, std::pmr::polymorphic_allocator<std::pair<Key, Val>>, size>;
+template <
+    std::unsigned_integral Key, typename Val, std::size_t size = k_default_page_size,
+    typename Mutex = std::shared_mutex>
+using dense_map =
+    dense_map<Key, Val, std::pmr::polymorphic_allocator<std::pair<Key, Val>>, size, Mutex>;
+
+template <
+    std::unsigned_integral Ty, std::size_t size = k_default_page_size,
+    typename Mutex = std::shared_mutex>
+using dense_set = dense_set<Ty, std::pmr::polymorphic_allocator<Ty>, size, Mutex>;
 }
 
 #endif
@@ -53,4 +102,10 @@ using unsync_compressed_allocator = unsync_allocator<compressed_pair<First, Seco
 template <typename First, typename Second>
 using unsync_pair_allocator = sync_allocator<std::pair<const First, Second>>;
 
+template <typename Ty>
+using sync_node_allocator = allocator<Ty, object_pool<Ty, spin_lock>>;
+
+template <typename Ty>
+using unsync_node_allocator = allocator<Ty, object_pool<Ty>>;
+
 } // namespace atom::utils
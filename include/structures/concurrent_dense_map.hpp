@@ -0,0 +1,524 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "core.hpp"
+#include "core/langdef.hpp"
+#include "memory/allocator.hpp"
+#include "structures.hpp"
+#include "thread/lock.hpp"
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Grace-period domain for deferred reclamation.
+ *
+ * Readers announce themselves in one of the cache-line sized slots picked by their thread, so
+ * concurrent readers on different cores never write the same cache line. Writers flip the epoch
+ * and wait until every slot drains the previous parity before freeing retired memory.
+ */
+class epoch_domain {
+    constexpr static std::size_t slot_count = 64;
+
+    struct alignas(cache_line_size) slot {
+        std::array<std::atomic<std::size_t>, 2> readers{};
+    };
+
+    static auto local_slot() noexcept -> std::size_t {
+        static std::atomic<std::size_t> next{};
+        thread_local const std::size_t index =
+            next.fetch_add(1, std::memory_order_relaxed) % slot_count;
+        return index;
+    }
+
+public:
+    epoch_domain()                               = default;
+    epoch_domain(const epoch_domain&)            = delete;
+    epoch_domain(epoch_domain&&)                 = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+    epoch_domain& operator=(epoch_domain&&)      = delete;
+    ~epoch_domain()                              = default;
+
+    /**
+     * @brief Enter a read-side critical section.
+     *
+     * @return The token that should be passed to `leave()`.
+     */
+    auto enter() noexcept -> std::size_t {
+        auto& readers = slots_[local_slot()].readers;
+        while (true) {
+            const auto epoch = epoch_.load();
+            readers[epoch & 1].fetch_add(1);
+            if (epoch_.load() == epoch) [[likely]] {
+                return epoch;
+            }
+            readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void leave(const std::size_t epoch) noexcept {
+        slots_[local_slot()].readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Wait until all readers that may observe memory unpublished before this call leave.
+     * @warning Writers calling this must be serialized.
+     */
+    void synchronize() noexcept {
+        const auto epoch = epoch_.fetch_add(1);
+        for (auto& slot : slots_) {
+            while (slot.readers[epoch & 1].load(std::memory_order_acquire) != 0) {
+                internal::cpu_relax();
+            }
+        }
+    }
+
+private:
+    std::array<slot, slot_count> slots_;
+    std::atomic<std::size_t> epoch_{};
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Dense map whose lookups never take a lock.
+ *
+ * Readers are validated by a sequence lock and protected from reclamation by an epoch domain, so
+ * `get()` and `contains()` only read shared cache lines. Writers are serialized by a mutex and
+ * retire replaced sparse directories and dense buffers until no reader can observe them.
+ * Values are copied out of the map, so they must be trivially copyable.
+ */
+template <std::unsigned_integral Key, typename Val, typename Alloc, std::size_t PageSize>
+class concurrent_dense_map {
+    static_assert(
+        std::is_trivially_copyable_v<Val>, "Values are read optimistically, they must be trivially "
+                                           "copyable.");
+
+    template <typename Target>
+    using allocator_t = typename rebind_allocator<Alloc>::template to<Target>::type;
+
+public:
+    using key_type    = Key;
+    using mapped_type = Val;
+    using value_type  = std::pair<key_type, mapped_type>;
+    using size_type   = std::size_t;
+
+private:
+    struct slot {
+        std::atomic<key_type> key;
+        alignas(mapped_type) std::array<std::byte, sizeof(mapped_type)> value;
+    };
+
+    // zero means empty, others are index + 1 in the dense buffer.
+    using page_t = std::array<std::atomic<size_type>, PageSize>;
+
+    using slot_alloc    = allocator_t<slot>;
+    using page_alloc    = allocator_t<page_t>;
+    using entry_alloc   = allocator_t<std::atomic<page_t*>>;
+    using slot_traits   = std::allocator_traits<slot_alloc>;
+    using page_traits   = std::allocator_traits<page_alloc>;
+    using entry_traits  = std::allocator_traits<entry_alloc>;
+    using retire_fn     = void (*)(concurrent_dense_map&, void*, size_type);
+    using retired_block = std::pair<std::pair<void*, size_type>, retire_fn>;
+
+    constexpr static size_type min_capacity = 16;
+
+    class read_guard {
+    public:
+        explicit read_guard(internal::epoch_domain& domain) noexcept
+            : domain_(domain), epoch_(domain.enter()) {}
+        read_guard(const read_guard&)            = delete;
+        read_guard(read_guard&&)                 = delete;
+        read_guard& operator=(const read_guard&) = delete;
+        read_guard& operator=(read_guard&&)      = delete;
+        ~read_guard() noexcept { domain_.leave(epoch_); }
+
+    private:
+        internal::epoch_domain& domain_;
+        std::size_t epoch_;
+    };
+
+public:
+    concurrent_dense_map() : concurrent_dense_map(Alloc{}) {}
+
+    template <typename Al>
+    explicit concurrent_dense_map(const Al& allocator)
+        : slot_alloc_(allocator), page_alloc_(allocator), entry_alloc_(allocator) {}
+
+    template <typename Al>
+    concurrent_dense_map(std::allocator_arg_t, const Al& allocator)
+        : concurrent_dense_map(allocator) {}
+
+    concurrent_dense_map(const concurrent_dense_map&)            = delete;
+    concurrent_dense_map(concurrent_dense_map&&)                 = delete;
+    concurrent_dense_map& operator=(const concurrent_dense_map&) = delete;
+    concurrent_dense_map& operator=(concurrent_dense_map&&)      = delete;
+
+    ~concurrent_dense_map() noexcept {
+        for (auto& [block, release] : retired_) {
+            release(*this, block.first, block.second);
+        }
+        auto* pages      = pages_.load(std::memory_order_relaxed);
+        const auto count = page_count_.load(std::memory_order_relaxed);
+        for (size_type i = 0; i < count; ++i) {
+            if (auto* page = pages[i].load(std::memory_order_relaxed)) {
+                release_page(*this, page, 1);
+            }
+        }
+        if (pages) {
+            release_directory(*this, pages, count);
+        }
+        if (auto* slots = slots_.load(std::memory_order_relaxed)) {
+            release_slots(*this, slots, capacity_.load(std::memory_order_relaxed));
+        }
+    }
+
+    /**
+     * @brief Copy the value mapped to the key without locking.
+     *
+     * @return The value, or `std::nullopt` if the key does not exist.
+     */
+    [[nodiscard]] auto get(const key_type key) const noexcept -> std::optional<mapped_type> {
+        std::array<std::byte, sizeof(mapped_type)> bytes;
+        if (read(key, bytes.data())) {
+            return std::bit_cast<mapped_type>(bytes);
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Copy the value mapped to the key without locking.
+     *
+     * @return If the key exists. `value` is untouched when it does not.
+     */
+    auto try_get(const key_type key, mapped_type& value) const noexcept -> bool {
+        std::array<std::byte, sizeof(mapped_type)> bytes;
+        if (read(key, bytes.data())) {
+            value = std::bit_cast<mapped_type>(bytes);
+            return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] auto contains(const key_type key) const noexcept -> bool {
+        return read(key, nullptr);
+    }
+
+    /**
+     * @brief Insert a value if the key does not exist.
+     *
+     * @return If the value was inserted.
+     */
+    template <typename... Args>
+    requires std::is_constructible_v<mapped_type, Args...>
+    auto emplace(const key_type key, Args&&... args) -> bool {
+        const mapped_type value(std::forward<Args>(args)...);
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        if (index_of(key) != 0) {
+            return false;
+        }
+        insert_unlocked(key, value);
+        reclaim_unlocked();
+        return true;
+    }
+
+    template <typename Value>
+    requires std::is_constructible_v<mapped_type, Value>
+    void insert_or_assign(const key_type key, Value&& val) {
+        const mapped_type value(std::forward<Value>(val));
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        if (const auto index = index_of(key); index != 0) {
+            auto* slots = slots_.load(std::memory_order_relaxed);
+            begin_write();
+            std::memcpy(slots[index - 1].value.data(), &value, sizeof(mapped_type));
+            end_write();
+        }
+        else {
+            insert_unlocked(key, value);
+            reclaim_unlocked();
+        }
+    }
+
+    /**
+     * @brief Erase the key by moving the last element into its place.
+     *
+     * @return If the key existed.
+     */
+    auto erase(const key_type key) -> bool {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        const auto index = index_of(key);
+        if (index == 0) {
+            return false;
+        }
+
+        auto* slots     = slots_.load(std::memory_order_relaxed);
+        const auto last = size_.load(std::memory_order_relaxed) - 1;
+        begin_write();
+        if (index - 1 != last) {
+            const auto back = slots[last].key.load(std::memory_order_relaxed);
+            slots[index - 1].key.store(back, std::memory_order_relaxed);
+            std::memcpy(
+                slots[index - 1].value.data(), slots[last].value.data(), sizeof(mapped_type));
+            sparse_entry(back).store(index, std::memory_order_relaxed);
+        }
+        sparse_entry(key).store(0, std::memory_order_relaxed);
+        size_.store(last, std::memory_order_relaxed);
+        end_write();
+        return true;
+    }
+
+    void reserve(const size_type size) {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        if (size > capacity_.load(std::memory_order_relaxed)) {
+            grow_slots(size);
+        }
+        if (size != 0) {
+            grow_directory(page_of(size - 1) + 1);
+        }
+        reclaim_unlocked();
+    }
+
+    /**
+     * @brief Remove all elements. Allocated pages and buffers are kept for reuse.
+     *
+     */
+    void clear() noexcept {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        auto* pages      = pages_.load(std::memory_order_relaxed);
+        auto* slots      = slots_.load(std::memory_order_relaxed);
+        const auto count = size_.load(std::memory_order_relaxed);
+        begin_write();
+        for (size_type i = 0; i < count; ++i) {
+            const auto key = slots[i].key.load(std::memory_order_relaxed);
+            pages[page_of(key)].load(std::memory_order_relaxed)->at(offset_of(key)).store(
+                0, std::memory_order_relaxed);
+        }
+        size_.store(0, std::memory_order_relaxed);
+        end_write();
+    }
+
+    /**
+     * @brief Visit every element while writers are blocked.
+     *
+     * @param fn Callable with `(key_type, const mapped_type&)`.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        std::unique_lock<std::mutex> lock{ mutex_ };
+        auto* slots      = slots_.load(std::memory_order_relaxed);
+        const auto count = size_.load(std::memory_order_relaxed);
+        for (size_type i = 0; i < count; ++i) {
+            const auto value = std::bit_cast<mapped_type>(slots[i].value);
+            fn(slots[i].key.load(std::memory_order_relaxed), value);
+        }
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_type {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+
+private:
+    static auto page_of(const key_type key) noexcept -> size_type { return key / PageSize; }
+    static auto offset_of(const key_type key) noexcept -> size_type { return key % PageSize; }
+
+    auto read(const key_type key, std::byte* out) const noexcept -> bool {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+
+        read_guard guard{ domain_ };
+        while (true) {
+            const auto sequence = sequence_.load(std::memory_order_acquire);
+            if (sequence & 1) [[unlikely]] {
+                internal::cpu_relax();
+                continue;
+            }
+
+            auto found = false;
+            // counts are published after the buffers they describe, load them first.
+            if (page < page_count_.load(std::memory_order_acquire)) {
+                auto* pages = pages_.load(std::memory_order_acquire);
+                if (auto* entry = pages[page].load(std::memory_order_acquire)) {
+                    const auto index    = entry->at(offset).load(std::memory_order_relaxed);
+                    const auto capacity = capacity_.load(std::memory_order_acquire);
+                    auto* slots         = slots_.load(std::memory_order_acquire);
+                    if (index != 0 && index <= capacity &&
+                        slots[index - 1].key.load(std::memory_order_relaxed) == key) {
+                        if (out) {
+                            std::memcpy(out, slots[index - 1].value.data(), sizeof(mapped_type));
+                        }
+                        found = true;
+                    }
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence) [[likely]] {
+                return found;
+            }
+        }
+    }
+
+    void begin_write() noexcept {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write() noexcept {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    auto sparse_entry(const key_type key) noexcept -> std::atomic<size_type>& {
+        auto* pages = pages_.load(std::memory_order_relaxed);
+        return pages[page_of(key)].load(std::memory_order_relaxed)->at(offset_of(key));
+    }
+
+    auto index_of(const key_type key) const noexcept -> size_type {
+        const auto page = page_of(key);
+        if (page >= page_count_.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        auto* entry = pages_.load(std::memory_order_relaxed)[page].load(std::memory_order_relaxed);
+        return entry ? entry->at(offset_of(key)).load(std::memory_order_relaxed) : 0;
+    }
+
+    void insert_unlocked(const key_type key, const mapped_type& value) {
+        const auto size = size_.load(std::memory_order_relaxed);
+        if (size == capacity_.load(std::memory_order_relaxed)) {
+            grow_slots(std::max(min_capacity, size * 2));
+        }
+        const auto page = page_of(key);
+        grow_directory(page + 1);
+        auto* pages = pages_.load(std::memory_order_relaxed);
+        if (pages[page].load(std::memory_order_relaxed) == nullptr) {
+            auto* entry = page_traits::allocate(page_alloc_, 1);
+            page_traits::construct(page_alloc_, entry);
+            pages[page].store(entry, std::memory_order_release);
+        }
+
+        auto* slots = slots_.load(std::memory_order_relaxed);
+        begin_write();
+        slots[size].key.store(key, std::memory_order_relaxed);
+        std::memcpy(slots[size].value.data(), &value, sizeof(mapped_type));
+        sparse_entry(key).store(size + 1, std::memory_order_relaxed);
+        size_.store(size + 1, std::memory_order_relaxed);
+        end_write();
+    }
+
+    void grow_slots(const size_type capacity) {
+        auto* old_slots    = slots_.load(std::memory_order_relaxed);
+        const auto old_cap = capacity_.load(std::memory_order_relaxed);
+        const auto size    = size_.load(std::memory_order_relaxed);
+
+        retired_.reserve(retired_.size() + 1);
+        auto* slots = slot_traits::allocate(slot_alloc_, capacity);
+        for (size_type i = 0; i < capacity; ++i) {
+            slot_traits::construct(slot_alloc_, slots + i);
+        }
+        for (size_type i = 0; i < size; ++i) {
+            slots[i].key.store(old_slots[i].key.load(std::memory_order_relaxed));
+            slots[i].value = old_slots[i].value;
+        }
+
+        // readers load capacity before the buffer, so a smaller capacity is always safe.
+        slots_.store(slots, std::memory_order_release);
+        capacity_.store(capacity, std::memory_order_release);
+        if (old_slots) {
+            retired_.push_back({ { old_slots, old_cap }, &release_slots });
+        }
+    }
+
+    void grow_directory(const size_type count) {
+        const auto old_count = page_count_.load(std::memory_order_relaxed);
+        if (count <= old_count) {
+            return;
+        }
+
+        auto* old_pages      = pages_.load(std::memory_order_relaxed);
+        const auto new_count = std::max(count, old_count * 2);
+        retired_.reserve(retired_.size() + 1);
+        auto* pages = entry_traits::allocate(entry_alloc_, new_count);
+        for (size_type i = 0; i < new_count; ++i) {
+            entry_traits::construct(
+                entry_alloc_, pages + i,
+                i < old_count ? old_pages[i].load(std::memory_order_relaxed) : nullptr);
+        }
+
+        pages_.store(pages, std::memory_order_release);
+        page_count_.store(new_count, std::memory_order_release);
+        if (old_pages) {
+            retired_.push_back({ { old_pages, old_count }, &release_directory });
+        }
+    }
+
+    /**
+     * @brief Free retired blocks once no reader could still be using them.
+     * @note Must be called outside of a write section, readers spin while it is open.
+     */
+    void reclaim_unlocked() noexcept {
+        if (retired_.empty()) {
+            return;
+        }
+        domain_.synchronize();
+        for (auto& [block, release] : retired_) {
+            release(*this, block.first, block.second);
+        }
+        retired_.clear();
+    }
+
+    static void release_slots(concurrent_dense_map& self, void* ptr, const size_type count) {
+        auto* slots = static_cast<slot*>(ptr);
+        for (size_type i = 0; i < count; ++i) {
+            slot_traits::destroy(self.slot_alloc_, slots + i);
+        }
+        slot_traits::deallocate(self.slot_alloc_, slots, count);
+    }
+
+    static void release_page(concurrent_dense_map& self, void* ptr, const size_type count) {
+        auto* page = static_cast<page_t*>(ptr);
+        page_traits::destroy(self.page_alloc_, page);
+        page_traits::deallocate(self.page_alloc_, page, count);
+    }
+
+    static void release_directory(concurrent_dense_map& self, void* ptr, const size_type count) {
+        auto* pages = static_cast<std::atomic<page_t*>*>(ptr);
+        for (size_type i = 0; i < count; ++i) {
+            entry_traits::destroy(self.entry_alloc_, pages + i);
+        }
+        entry_traits::deallocate(self.entry_alloc_, pages, count);
+    }
+
+    // read mostly
+    alignas(cache_line_size) std::atomic<size_type> sequence_{};
+    std::atomic<std::atomic<page_t*>*> pages_{};
+    std::atomic<size_type> page_count_{};
+    std::atomic<slot*> slots_{};
+    std::atomic<size_type> capacity_{};
+    std::atomic<size_type> size_{};
+
+    // writer only
+    alignas(cache_line_size) mutable std::mutex mutex_;
+    std::vector<retired_block> retired_;
+    slot_alloc slot_alloc_;
+    page_alloc page_alloc_;
+    entry_alloc entry_alloc_;
+
+    mutable internal::epoch_domain domain_;
+};
+
+} // namespace atom::utils
@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "structures.hpp"
+
+namespace atom::utils {
+
+/**
+ * @brief Keeps the keys shared by several dense maps packed at the front of each of them.
+ *
+ * The first `size()` elements of every map hold the same keys in the same order, so they could be
+ * walked in lock-step by position without any lookup. Keys inserted into or about to be erased
+ * from the maps directly must be reported through `track` and `untrack`, otherwise the maps need
+ * to be `pack`ed again.
+ * @tparam Maps `dense_map`s sharing the same key type.
+ */
+template <typename... Maps>
+class dense_group {
+    static_assert(sizeof...(Maps) != 0, "A group needs at least one map");
+
+    using first_map = std::tuple_element_t<0, std::tuple<Maps...>>;
+
+public:
+    using key_type  = typename first_map::key_type;
+    using size_type = std::size_t;
+
+    static_assert(
+        (std::is_same_v<key_type, typename Maps::key_type> && ...),
+        "Maps in a group should share the key type");
+
+    /**
+     * @brief Group the maps and pack the keys they share.
+     *
+     */
+    explicit dense_group(Maps&... maps) : maps_(maps...) { pack(); }
+
+    /**
+     * @brief Pack the shared keys again from scratch.
+     *
+     * Keys are taken from the smallest map, and keep the order they have there.
+     * @return The number of shared keys.
+     */
+    auto pack() -> size_type {
+        size_     = 0;
+        auto lead = smallest();
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((Is == lead ? pack_from<Is>() : void()), ...);
+        }(std::index_sequence_for<Maps...>{});
+        return size_;
+    }
+
+    /**
+     * @brief Pack a key that was inserted into the maps.
+     *
+     * @return Whether the key became part of the group.
+     */
+    auto track(const key_type key) -> bool {
+        if (packed(key) || !in_all(key)) {
+            return false;
+        }
+        place(key, size_++);
+        return true;
+    }
+
+    /**
+     * @brief Move a key out of the packed range, so it could be erased from any of the maps.
+     *
+     * @return Whether the key was part of the group.
+     */
+    auto untrack(const key_type key) -> bool {
+        if (!packed(key)) {
+            return false;
+        }
+        place(key, --size_);
+        return true;
+    }
+
+    /**
+     * @brief Whether the key is in every map and packed.
+     *
+     */
+    [[nodiscard]] auto contains(const key_type key) const -> bool { return packed(key); }
+
+    /**
+     * @brief Call `func(key, values...)` for every packed key, values taken from each map.
+     *
+     */
+    template <typename Func>
+    void each(Func&& func) {
+        std::apply(
+            [&](auto& lead, auto&... rest) {
+                for (size_type index = 0; index < size_; ++index) {
+                    func(
+                        std::as_const(lead.begin()[index].first), lead.begin()[index].second,
+                        rest.begin()[index].second...);
+                }
+            },
+            maps_);
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+    template <std::size_t Index>
+    [[nodiscard]] auto get() noexcept -> std::tuple_element_t<Index, std::tuple<Maps...>>& {
+        return std::get<Index>(maps_);
+    }
+
+private:
+    [[nodiscard]] auto smallest() const noexcept -> size_type {
+        return std::apply(
+            [](const auto&... maps) {
+                const std::array<size_type, sizeof...(Maps)> sizes{ maps.size()... };
+                return static_cast<size_type>(std::ranges::min_element(sizes) - sizes.begin());
+            },
+            maps_);
+    }
+
+    /**
+     * @brief Walk the map at `Index` and pull every key found in all maps to the packed range.
+     *
+     * Swapping only moves elements that were already visited, so the walk could go on in place.
+     */
+    template <std::size_t Index>
+    void pack_from() {
+        auto& lead = std::get<Index>(maps_);
+        for (size_type index = 0; index < lead.size(); ++index) {
+            const auto key = lead.begin()[index].first;
+            if (in_all(key)) {
+                place(key, size_++);
+            }
+        }
+    }
+
+    [[nodiscard]] auto packed(const key_type key) const -> bool {
+        const auto& lead = std::get<0>(maps_);
+        const auto iter  = lead.find(key);
+        return iter != lead.end() && static_cast<size_type>(iter - lead.begin()) < size_;
+    }
+
+    [[nodiscard]] auto in_all(const key_type key) const -> bool {
+        return std::apply(
+            [key](const auto&... maps) { return (maps.contains(key) && ...); }, maps_);
+    }
+
+    void place(const key_type key, const size_type position) {
+        std::apply(
+            [key, position](auto&... maps) {
+                (maps.swap_elements(key, maps.begin()[position].first), ...);
+            },
+            maps_);
+    }
+
+    std::tuple<Maps&...> maps_;
+    size_type size_{};
+};
+
+} // namespace atom::utils
@@ -3,8 +3,14 @@
 #if defined(__cpp_concepts)
     #include <concepts>
 #endif
+#include <algorithm>
 #include <initializer_list>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 #if defined(__cpp_concepts)
@@ -17,14 +23,71 @@
 #include "memory/storage.hpp"
 #include "structures.hpp"
 #include "thread.hpp"
-#include "thread/lock_keeper.hpp"
+#include "thread/lock.hpp"
 
 namespace atom::utils {
 
+/**
+ * @brief Layout of keys packing an index in the low bits and a version in the high bits.
+ *
+ * A recycled index gets a new version, so handles taken before recycling no longer match. With
+ * zero version bits the whole key is the index.
+ */
+template <std::unsigned_integral Key, std::size_t VersionBits>
+struct versioned_key_traits {
+    static_assert(
+        VersionBits < std::numeric_limits<Key>::digits, "At least one bit is needed for the index");
+
+    using key_type = Key;
+
+    constexpr static std::size_t index_bits   = std::numeric_limits<key_type>::digits - VersionBits;
+    constexpr static std::size_t version_bits = VersionBits;
+
+    constexpr static key_type index_mask = std::numeric_limits<key_type>::max() >> VersionBits;
+    constexpr static key_type version_mask =
+        std::numeric_limits<key_type>::max() >> (index_bits - 1) >> 1;
+
+    [[nodiscard]] constexpr static auto index(const key_type key) noexcept -> key_type {
+        return key & index_mask;
+    }
+
+    [[nodiscard]] constexpr static auto version(const key_type key) noexcept -> key_type {
+        if constexpr (VersionBits == 0) {
+            return 0;
+        }
+        else {
+            return static_cast<key_type>(key >> index_bits);
+        }
+    }
+
+    [[nodiscard]] constexpr static auto make(const key_type index, const key_type version) noexcept
+        -> key_type {
+        if constexpr (VersionBits == 0) {
+            return index;
+        }
+        else {
+            return static_cast<key_type>(
+                (index & index_mask) | ((version & version_mask) << index_bits));
+        }
+    }
+
+    /**
+     * @brief The same index with the next version, wrapping around to zero.
+     *
+     */
+    [[nodiscard]] constexpr static auto next(const key_type key) noexcept -> key_type {
+        return make(index(key), static_cast<key_type>(version(key) + 1));
+    }
+};
+
 #if _HAS_CXX20
-template <std::unsigned_integral Key, typename Val, typename Alloc, std::size_t PageSize>
+template <
+    std::unsigned_integral Key, typename Val, typename Alloc, std::size_t PageSize, typename Mutex,
+    std::size_t VersionBits, bool InlinePages>
 #elif _HAS_CXX17
-template <typename Kty, typename Ty, typename Alloc, std::size_t PageSize, typename>
+template <
+    typename Kty, typename Ty, typename Alloc, std::size_t PageSize, typename Mutex,
+    std::size_t VersionBits, bool InlinePages, typename>
 #endif
 class dense_map {
     template <typename Target>
@@ -61,27 +124,42 @@ public:
     using const_reverse_iterator = typename vector::const_reverse_iterator;
 
 private:
-    using array_t            = std::array<size_type, PageSize>;
-    using storage_t          = ::atom::utils::unique_storage<array_t, allocator_t<array_t>>;
-    using shared_lock_keeper = ::atom::utils::lock_keeper<2, std::shared_mutex, std::shared_lock>;
-    using unique_lock_keeper = ::atom::utils::lock_keeper<2, std::shared_mutex, std::unique_lock>;
+    using array_t     = std::array<size_type, PageSize>;
+    using storage_t   = ::atom::utils::unique_storage<
+          array_t, allocator_t<array_t>, InlinePages ? sizeof(array_t) : 0>;
+    using shared_lock = ::atom::utils::internal::shared_guard_t<Mutex>;
+    using unique_lock = ::atom::utils::internal::unique_guard_t<Mutex>;
 
 public:
+    using mutex_type = Mutex;
+
+    /**
+     * @brief Packing of index and version in keys.
+     *
+     * Pages are addressed by the index only. The version is kept in the sparse slot next to the
+     * dense index, so a key with a stale version is rejected by the same load that finds it.
+     */
+    using key_traits = versioned_key_traits<key_type, VersionBits>;
+
     /**
      * @brief Default constructor.
      *
      */
-    _CONSTEXPR20 dense_map() : dense_(), sparse_() {}
+    _CONSTEXPR20 dense_map() : dense_(), sparse_(), page_counts_() {}
 
     /**
      * @brief Construct with allocator.
      *
      */
     template <typename Al>
-    _CONSTEXPR20 dense_map(const Al& allocator) : dense_(allocator), sparse_(allocator) {}
+    _CONSTEXPR20 dense_map(const Al& allocator)
+        : dense_(allocator_t<value_type>(allocator)), sparse_(allocator_t<storage_t>(allocator)),
+          page_counts_(allocator_t<size_type>(allocator)) {}
 
     template <typename Al>
-    _CONSTEXPR20 dense_map(std::allocator_arg_t, const Al& al) : dense_(al), sparse_(al) {}
+    _CONSTEXPR20 dense_map(std::allocator_arg_t, const Al& al)
+        : dense_(allocator_t<value_type>(al)), sparse_(allocator_t<storage_t>(al)),
+          page_counts_(allocator_t<size_type>(al)) {}
 
     /**
      * @brief Construct by iterators and allocator.
@@ -91,12 +169,11 @@ public:
     requires concepts::constructible_from_iterator<IFirst, value_type>
     _CONSTEXPR20 dense_map(IFirst first, ILast last, const Al& al) noexcept(
         noexcept(dense_map(std::allocator_arg, al, first, last)))
-        : dense_(first, last, al), sparse_(al) {
-        for (const auto& [key, val] : dense_) {
-            auto page   = page_of(key);
-            auto offset = offset_of(key);
-            check_page(page);
-            sparse_[page]->at(offset) = dense_.size();
+        : dense_(allocator_t<value_type>(al)), sparse_(allocator_t<storage_t>(al)),
+          page_counts_(allocator_t<size_type>(al)) {
+        for (; first != last; ++first) {
+            const auto& [key, val] = *first;
+            emplace_unlocked(key, val);
         }
     }
 
@@ -121,19 +198,17 @@ public:
      * @brief Construct by initializer list and allocator.
      *
      */
-    template <typename Al, typename Pair = value_type>
+    template <typename Al = Alloc, typename Pair = value_type>
     requires requires {
         typename Pair::first_type;
         typename Pair::second_type;
     } && std::is_constructible_v<value_type, typename Pair::first_type, typename Pair::second_type>
     _CONSTEXPR20 dense_map(std::initializer_list<Pair> il, const Al& allocator = Alloc{})
-        : dense_(il.begin(), il.end(), allocator), sparse_(allocator) {
-        for (auto i = 0; i < il.size(); ++i) {
-            const auto& [key, val] = dense_[i];
-            auto page              = page_of(key);
-            auto offset            = offset_of(key);
-            check_page(page);
-            sparse_[page]->at(offset) = i;
+        : dense_(allocator_t<value_type>(allocator)), sparse_(allocator_t<storage_t>(allocator)),
+          page_counts_(allocator_t<size_type>(allocator)) {
+        dense_.reserve(il.size());
+        for (const auto& [key, val] : il) {
+            emplace_unlocked(key, val);
         }
     }
 
@@ -146,24 +221,28 @@ public:
         : dense_map(il, al) {}
 
     _CONSTEXPR20 dense_map(dense_map&& that) noexcept
-        : dense_(std::move(that.dense_)), sparse_(std::move(that.sparse_)) {}
+        : dense_(std::move(that.dense_)), sparse_(std::move(that.sparse_)),
+          page_counts_(std::move(that.page_counts_)) {}
 
     dense_map& operator=(dense_map&& that) noexcept {
         if (this != &that) {
-            unique_lock_keeper that_keeper{ that.dense_mutex_, that.sparse_mutex_ };
-            unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
-            dense_  = std::move(that.dense_);
-            sparse_ = std::move(that.sparse_);
+            std::scoped_lock lock{ mutex_, that.mutex_ };
+            dense_       = std::move(that.dense_);
+            sparse_      = std::move(that.sparse_);
+            page_counts_ = std::move(that.page_counts_);
         }
         return *this;
     }
 
     dense_map(const dense_map& that)
-        : dense_(that.dense_), sparse_(that.sparse_.size(), that.get_allocator()) {
+        : dense_(that.dense_), sparse_(allocator_t<storage_t>(that.get_allocator())),
+          page_counts_(that.page_counts_) {
+        sparse_.reserve(that.sparse_.size());
         for (const auto& page : that.sparse_) {
-            unique_storage<array_t, allocator_t<array_t>> storage{ std::allocator_arg,
-                                                                   dense_.get_allocator() };
-            storage = *page;
+            storage_t storage{ std::allocator_arg, dense_.get_allocator() };
+            if (page) {
+                storage = *page;
+            }
             sparse_.emplace_back(std::move(storage));
         }
     }
@@ -173,6 +252,7 @@ public:
             dense_map temp(that);
             std::swap(dense_, temp.dense_);
             std::swap(sparse_, temp.sparse_);
+            std::swap(page_counts_, temp.page_counts_);
         }
         return *this;
     }
@@ -182,61 +262,49 @@ public:
     _NODISCARD auto at(const key_type key) -> Val& {
         auto page   = page_of(key);
         auto offset = offset_of(key);
-        shared_lock_keeper lock{ dense_mutex_, sparse_mutex_ };
-        return dense_[sparse_[page]->at(offset)].second;
+        shared_lock lock{ mutex_ };
+        return dense_[index_at(page, offset)].second;
     }
 
     _NODISCARD auto at(const key_type key) const -> const Val& {
         auto page   = page_of(key);
         auto offset = offset_of(key);
-        shared_lock_keeper lock{ dense_mutex_, sparse_mutex_ };
-        return dense_[sparse_[page]->at(offset)].second;
+        shared_lock lock{ mutex_ };
+        return dense_[index_at(page, offset)].second;
     }
 
     auto operator[](const key_type key) -> Val& {
         auto page   = page_of(key);
         auto offset = offset_of(key);
-        shared_lock_keeper lock{ dense_mutex_, sparse_mutex_ };
-        return dense_[sparse_[page]->at(offset)].second;
+        shared_lock lock{ mutex_ };
+        return dense_[index_at(page, offset)].second;
     }
 
-    // template <typename... Mappedty>
-    // std::pair<iterator, bool> try_emplace(const key_type keyval, Mappedty&&... mapval) {}
-
-    template <typename ValTy>
-    _CONSTEXPR26 void emplace(const key_type& key, ValTy&& val) {
-        auto page   = page_of(key);
-        auto offset = offset_of(key);
-
-        unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
-        auto current_page_count = sparse_.size();
-        try {
-            check_page(page);
-            sparse_[page]->at(offset) = dense_.size();
-            try {
-                dense_.emplace_back(key, std::forward<ValTy>(val));
-            }
-            catch (...) {
-                sparse_[page]->at(offset) = 0;
-                throw;
-            }
-        }
-        catch (...) {
-            pop_page_to(current_page_count);
-        }
+    /**
+     * @brief Construct the mapped value in place if the key does not exist.
+     *
+     * @return Iterator to the element with the key, and whether it was inserted.
+     */
+    template <typename... Args>
+    requires std::is_constructible_v<mapped_type, Args...>
+    auto emplace(const key_type key, Args&&... args) -> std::pair<iterator, bool> {
+        unique_lock lock{ mutex_ };
+        return emplace_unlocked(key, std::forward<Args>(args)...);
     }
 
-    template <typename... Tys>
-    requires std::is_constructible_v<value_type, Tys...>
-    _CONSTEXPR26 std::pair<iterator, bool> emplace(Tys&&... vals) {
-        // TODO: finish this function
+    template <typename Pair>
+    requires std::is_constructible_v<value_type, Pair>
+    auto emplace(Pair&& pair) -> std::pair<iterator, bool> {
+        value_type value(std::forward<Pair>(pair));
+        unique_lock lock{ mutex_ };
+        return emplace_unlocked(value.first, std::move(value.second));
     }
 
     auto erase(const key_type key) {
         auto page   = page_of(key);
         auto offset = offset_of(key);
 
-        unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
+        unique_lock lock{ mutex_ };
         if (contains_impl(key, page, offset)) {
             erase_without_check_impl_unlocked(page, offset);
         }
@@ -248,16 +316,53 @@ public:
         erase_without_check_impl(page, offset);
     }
 
+    /**
+     * @brief Reserve the dense array and the page directory for keys below `size`.
+     *
+     * Pages themselves are still allocated when a key in them is first inserted.
+     */
     void reserve(const size_type size) {
         auto page = page_of(size);
-        unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
-        check_page(page);
+        unique_lock lock{ mutex_ };
+        grow_directory(page + 1);
         dense_.reserve(size);
     }
 
+    /**
+     * @brief Give back memory that is no longer in use.
+     *
+     * Empty pages at the end of the page directory are dropped, then the directory and the dense
+     * array release their spare capacity. Empty pages below the largest key are freed as they
+     * empty, but keep their entry in the directory and their count: the directory stays flat, so
+     * a lookup takes a single indirection. A few keys spread up to a large one therefore still
+     * cost an entry for every page up to it.
+     */
+    void shrink_to_fit() {
+        unique_lock lock{ mutex_ };
+        auto count = sparse_.size();
+        while (count != 0 && !sparse_[count - 1]) {
+            --count;
+        }
+        pop_page_to(count);
+        sparse_.shrink_to_fit();
+        page_counts_.shrink_to_fit();
+        dense_.shrink_to_fit();
+    }
+
+    /**
+     * @brief Number of sparse pages currently allocated.
+     *
+     */
+    _NODISCARD auto page_count() const noexcept -> size_type {
+        shared_lock lock{ mutex_ };
+        return static_cast<size_type>(
+            std::ranges::count_if(page_counts_, [](const size_type count) { return count != 0; }));
+    }
+
     auto contains(const key_type key) const -> bool {
         auto page   = page_of(key);
         auto offset = offset_of(key);
+        shared_lock lock{ mutex_ };
         return contains_impl(key, page, offset);
     }
 
@@ -265,9 +370,9 @@ public:
         auto page   = page_of(key);
         auto offset = offset_of(key);
 
-        shared_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
+        shared_lock lock{ mutex_ };
         if (contains_impl(key, page, offset)) {
-            return dense_.begin() + sparse_[page]->at(offset);
+            return dense_.begin() + index_at(page, offset);
         }
         else {
             return dense_.end();
@@ -278,22 +383,197 @@ public:
         auto page   = page_of(key);
         auto offset = offset_of(key);
 
-        shared_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
+        shared_lock lock{ mutex_ };
         if (contains_impl(key, page, offset)) {
-            return dense_.begin() + sparse_[page]->at(offset);
+            return dense_.begin() + index_at(page, offset);
         }
         else {
             return dense_.end();
         }
     }
 
+    /**
+     * @brief Insert every pair in the range that has a new key, taking the lock only once.
+     *
+     * Sparse pages and the dense array are sized up front when the range allows it, the dense
+     * array at least doubling so that many small batches stay amortized linear. Sparse slots of
+     * upcoming keys are prefetched when the range is random access.
+     * @return The number of inserted elements.
+     */
+    template <std::ranges::input_range Rng>
+    requires std::is_constructible_v<value_type, std::ranges::range_reference_t<Rng>>
+    auto insert_range(Rng&& range) -> size_type {
+        constexpr bool keyed =
+            requires(std::ranges::range_reference_t<Rng> elem) { std::get<0>(elem); };
+
+        unique_lock lock{ mutex_ };
+        if constexpr (std::ranges::forward_range<Rng> && keyed) {
+            size_type max_page{};
+            size_type count{};
+            for (auto&& elem : range) {
+                max_page = std::max(max_page, page_of(std::get<0>(elem)));
+                ++count;
+            }
+            if (count != 0) {
+                grow_directory(max_page + 1);
+                if (const auto needed = dense_.size() + count; needed > dense_.capacity()) {
+                    dense_.reserve(std::max(needed, 2 * dense_.capacity()));
+                }
+            }
+        }
+
+        const auto size = dense_.size();
+        if constexpr (std::ranges::random_access_range<Rng> && keyed) {
+            const auto first = std::ranges::begin(range);
+            const auto count = static_cast<size_type>(std::ranges::distance(range));
+            for (size_type i = 0; i < count; ++i) {
+                if (i + k_prefetch_distance < count) {
+                    prefetch_sparse(std::get<0>(first[i + k_prefetch_distance]));
+                }
+                value_type value(first[i]);
+                emplace_unlocked(value.first, std::move(value.second));
+            }
+        }
+        else {
+            for (auto&& elem : range) {
+                value_type value(std::forward<decltype(elem)>(elem));
+                emplace_unlocked(value.first, std::move(value.second));
+            }
+        }
+        return dense_.size() - size;
+    }
+
+    /**
+     * @brief Erase every key in the range, taking the lock only once.
+     *
+     * @return The number of erased elements.
+     */
+    template <std::ranges::input_range Rng>
+    requires std::is_convertible_v<std::ranges::range_reference_t<Rng>, key_type>
+    auto erase_range(Rng&& keys) -> size_type {
+        unique_lock lock{ mutex_ };
+        const auto size = dense_.size();
+        if constexpr (std::ranges::random_access_range<Rng>) {
+            const auto first = std::ranges::begin(keys);
+            const auto count = static_cast<size_type>(std::ranges::distance(keys));
+            for (size_type i = 0; i < count; ++i) {
+                if (i + k_prefetch_distance < count) {
+                    prefetch_sparse(first[i + k_prefetch_distance]);
+                }
+                erase_unlocked(first[i]);
+            }
+        }
+        else {
+            for (auto&& key : keys) {
+                erase_unlocked(key);
+            }
+        }
+        return size - dense_.size();
+    }
+
+    /**
+     * @brief Look up a batch of keys, taking the lock only once.
+     *
+     * Sparse slots and dense elements of upcoming keys are prefetched while looking up the
+     * current one.
+     * @param keys Keys to look up.
+     * @param out Receives the iterator of each key, or `end()` for missing keys. Must be at least
+     * as long as `keys`.
+     * @return The number of keys found.
+     */
+    auto find_many(std::span<const key_type> keys, std::span<iterator> out) noexcept
+        -> size_type {
+        shared_lock lock{ mutex_ };
+        return find_many_unlocked(keys, out, dense_.begin(), dense_.end());
+    }
+
+    auto find_many(std::span<const key_type> keys, std::span<const_iterator> out) const noexcept
+        -> size_type {
+        shared_lock lock{ mutex_ };
+        return find_many_unlocked(keys, out, dense_.cbegin(), dense_.cend());
+    }
+
+    /**
+     * @brief Sort the elements in place by key, then patch the sparse index.
+     *
+     * Versioned keys are ordered by their index.
+     */
+    void sort() {
+        sort([](const value_type& lhs, const value_type& rhs) {
+            return key_traits::index(lhs.first) < key_traits::index(rhs.first);
+        });
+    }
+
+    /**
+     * @brief Sort the elements in place, then patch the sparse index.
+     *
+     * @param comp Strict weak ordering over `value_type`.
+     */
+    template <typename Compare>
+    requires std::predicate<Compare&, const value_type&, const value_type&>
+    void sort(Compare comp) {
+        unique_lock lock{ mutex_ };
+        std::sort(dense_.begin(), dense_.end(), comp);
+        for (size_type index = 0; index < dense_.size(); ++index) {
+            const auto key                            = dense_[index].first;
+            sparse_[page_of(key)]->at(offset_of(key)) = make_slot(index, key);
+        }
+    }
+
+    /**
+     * @brief Move the keys shared with another container to the front, in the order they have
+     * there.
+     *
+     * The other container is iterated without taking its lock.
+     * @param other Range of keys, or of pairs keyed by their first member, such as another
+     * `dense_map` or a `dense_set`.
+     * @return The number of shared keys, which now take the first positions.
+     */
+    template <std::ranges::input_range Rng>
+    auto sort_as(const Rng& other) -> size_type {
+        unique_lock lock{ mutex_ };
+        size_type position{};
+        for (const auto& elem : other) {
+            const key_type key = key_of(elem);
+            const auto page    = page_of(key);
+            const auto offset  = offset_of(key);
+            if (contains_impl(key, page, offset)) {
+                if (const auto index = index_at(page, offset); index >= position) {
+                    swap_unlocked(index, position);
+                    ++position;
+                }
+            }
+        }
+        return position;
+    }
+
+    /**
+     * @brief Swap the positions of two keys in the dense array.
+     *
+     * @return Whether both keys exist.
+     */
+    auto swap_elements(const key_type lhs, const key_type rhs) -> bool {
+        unique_lock lock{ mutex_ };
+        const auto lhs_page   = page_of(lhs);
+        const auto lhs_offset = offset_of(lhs);
+        const auto rhs_page   = page_of(rhs);
+        const auto rhs_offset = offset_of(rhs);
+        if (!contains_impl(lhs, lhs_page, lhs_offset) ||
+            !contains_impl(rhs, rhs_page, rhs_offset)) {
+            return false;
+        }
+        swap_unlocked(index_at(lhs_page, lhs_offset), index_at(rhs_page, rhs_offset));
+        return true;
+    }
+
     _NODISCARD _CONSTEXPR20 bool empty() const noexcept { return dense_.empty(); }
 
     _NODISCARD _CONSTEXPR20 size_type size() const noexcept { return dense_.size(); }
 
     void clear() noexcept {
-        unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
+        unique_lock lock{ mutex_ };
         sparse_.clear();
+        page_counts_.clear();
         dense_.clear();
     }
 
@@ -332,34 +612,244 @@ public:
     _NODISCARD _CONSTEXPR20 auto get_allocator() const noexcept { return dense_.get_allocator(); }
 
 private:
-    static size_type page_of(const key_type key) noexcept { return key / PageSize; }
-    static size_type offset_of(const key_type key) noexcept { return key % PageSize; }
-    void check_page(const size_type page) noexcept {
+    template <typename...>
+    friend class join_view;
+
+    constexpr static size_type k_prefetch_distance = 8;
+
+    // the version of the key lives above the dense index in its sparse slot.
+    constexpr static size_type k_slot_index_bits =
+        std::numeric_limits<size_type>::digits - VersionBits;
+
+    static size_type page_of(const key_type key) noexcept {
+        return key_traits::index(key) / PageSize;
+    }
+    static size_type offset_of(const key_type key) noexcept {
+        return key_traits::index(key) % PageSize;
+    }
+
+    static size_type make_slot(const size_type index, const key_type key) noexcept {
+        if constexpr (VersionBits == 0) {
+            return index;
+        }
+        else {
+            return index | (static_cast<size_type>(key_traits::version(key)) << k_slot_index_bits);
+        }
+    }
+
+    static size_type index_of_slot(const size_type slot) noexcept {
+        if constexpr (VersionBits == 0) {
+            return slot;
+        }
+        else {
+            return slot & (std::numeric_limits<size_type>::max() >> VersionBits);
+        }
+    }
+
+    static bool version_matches(const size_type slot, const key_type key) noexcept {
+        if constexpr (VersionBits == 0) {
+            return true;
+        }
+        else {
+            return (slot >> k_slot_index_bits) == key_traits::version(key);
+        }
+    }
+
+    size_type index_at(const size_type page, const size_type offset) const noexcept {
+        return index_of_slot(sparse_[page]->at(offset));
+    }
+
+    /**
+     * @brief The mapped value of the key, or nullptr. The caller holds the lock.
+     *
+     */
+    auto probe_unlocked(const key_type key) noexcept -> mapped_type* {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        return contains_impl(key, page, offset) ? &dense_[index_at(page, offset)].second : nullptr;
+    }
+
+    auto probe_unlocked(const key_type key) const noexcept -> const mapped_type* {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        return contains_impl(key, page, offset) ? &dense_[index_at(page, offset)].second : nullptr;
+    }
+
+    template <typename Elem>
+    static key_type key_of(const Elem& elem) noexcept {
+        if constexpr (std::is_convertible_v<const Elem&, key_type>) {
+            return elem;
+        }
+        else {
+            return std::get<0>(elem);
+        }
+    }
+
+    void swap_unlocked(const size_type lhs, const size_type rhs) {
+        if (lhs == rhs) {
+            return;
+        }
+        std::swap(dense_[lhs], dense_[rhs]);
+        const auto lhs_key                                = dense_[lhs].first;
+        const auto rhs_key                                = dense_[rhs].first;
+        sparse_[page_of(lhs_key)]->at(offset_of(lhs_key)) = make_slot(lhs, lhs_key);
+        sparse_[page_of(rhs_key)]->at(offset_of(rhs_key)) = make_slot(rhs, rhs_key);
+    }
+
+    /**
+     * @brief Make sure the page is allocated.
+     *
+     * Pages skipped on the way stay empty in the directory, so a high key costs one page instead
+     * of every page below it.
+     */
+    void check_page(const size_type page) {
+        grow_directory(page + 1);
+        if (!sparse_[page]) {
+            sparse_[page] = array_t{};
+        }
+    }
+
+    /**
+     * @brief Grow the page directory to `count` entries without allocating any page.
+     *
+     */
+    void grow_directory(const size_type count) {
         const auto current_page = sparse_.size();
         try {
-            while (page >= sparse_.size()) {
+            if (page_counts_.size() < count) {
+                page_counts_.resize(count);
+            }
+            if (sparse_.capacity() < count) {
+                // geometric, or adding pages one by one would copy the directory every time.
+                sparse_.reserve(std::max(count, sparse_.capacity() * 2));
+            }
+            while (count > sparse_.size()) {
                 // BUG: could not emplace it directly
-                storage_t storage{ std::allocator_arg, dense_.get_allocator(), construct_at_once };
+                storage_t storage{ std::allocator_arg, dense_.get_allocator() };
                 sparse_.emplace_back(std::move(storage));
             }
         }
         catch (...) {
-            while (sparse_.size() != current_page) {
-                sparse_.pop_back();
-            }
+            pop_page_to(current_page);
+            throw;
         }
     }
+
     void pop_page_to(const size_type page) noexcept {
-        while (sparse_.size() != page) {
+        while (sparse_.size() > page) {
             sparse_.pop_back();
         }
+        while (page_counts_.size() > page) {
+            page_counts_.pop_back();
+        }
+    }
+
+    void release_page_if_empty(const size_type page) noexcept {
+        if (page < sparse_.size() && page_counts_[page] == 0) {
+            sparse_[page].reset();
+        }
+    }
+
+    template <typename... Args>
+    auto emplace_unlocked(const key_type key, Args&&... args) -> std::pair<iterator, bool> {
+        auto page   = page_of(key);
+        auto offset = offset_of(key);
+        if (occupied_impl(key, page, offset)) {
+            return { dense_.begin() + index_at(page, offset), false };
+        }
+
+        const auto current_page_count = sparse_.size();
+        try {
+            check_page(page);
+            dense_.emplace_back(
+                std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        catch (...) {
+            release_page_if_empty(page);
+            pop_page_to(current_page_count);
+            throw;
+        }
+        sparse_[page]->at(offset) = make_slot(dense_.size() - 1, key);
+        ++page_counts_[page];
+        return { dense_.end() - 1, true };
+    }
+
+    void erase_unlocked(const key_type key) {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        if (contains_impl(key, page, offset)) {
+            erase_without_check_impl_unlocked(page, offset);
+        }
     }
+
+    void prefetch_sparse(const key_type key) const noexcept {
+        if (const auto page = page_of(key); page < sparse_.size() && sparse_[page]) {
+            ATOM_PREFETCH(sparse_[page]->data() + offset_of(key));
+        }
+    }
+
+    void prefetch_dense(const key_type key) const noexcept {
+        if (const auto page = page_of(key); page < sparse_.size() && sparse_[page]) {
+            ATOM_PREFETCH(dense_.data() + index_at(page, offset_of(key)));
+        }
+    }
+
+    template <typename Iter>
+    auto find_many_unlocked(
+        std::span<const key_type> keys, std::span<Iter> out, Iter first, Iter last) const noexcept
+        -> size_type {
+        const auto count = std::min(keys.size(), out.size());
+        // the sparse slot is fetched two rounds ahead, so the dense element could be fetched by
+        // the time its index is known.
+        for (size_type i = 0; i < count && i < k_prefetch_distance; ++i) {
+            prefetch_sparse(keys[i]);
+        }
+
+        size_type found{};
+        for (size_type i = 0; i < count; ++i) {
+            if (i + 2 * k_prefetch_distance < count) {
+                prefetch_sparse(keys[i + 2 * k_prefetch_distance]);
+            }
+            if (i + k_prefetch_distance < count) {
+                prefetch_dense(keys[i + k_prefetch_distance]);
+            }
+
+            const auto key    = keys[i];
+            const auto page   = page_of(key);
+            const auto offset = offset_of(key);
+            if (contains_impl(key, page, offset)) {
+                out[i] = first + index_at(page, offset);
+                ++found;
+            }
+            else {
+                out[i] = last;
+            }
+        }
+        return found;
+    }
+
     [[nodiscard]] auto contains_impl(
         const key_type key, const size_type page, const size_type offset) const noexcept -> bool {
-        return dense_.size() && sparse_.size() > page
-                   ? sparse_[page]->at(offset) ? true
-                                               : dense_[sparse_[page]->at(offset)].first == key
-                   : false;
+        if (dense_.empty() || sparse_.size() <= page || !sparse_[page]) {
+            return false;
+        }
+        // empty slots are zero, which is also the slot of the first element when its version is 0.
+        const auto slot = sparse_[page]->at(offset);
+        return version_matches(slot, key) && (slot != 0 || dense_.front().first == key);
+    }
+
+    /**
+     * @brief Whether the index of the key is taken, whatever the version.
+     *
+     */
+    [[nodiscard]] auto occupied_impl(
+        const key_type key, const size_type page, const size_type offset) const noexcept -> bool {
+        if (dense_.empty() || sparse_.size() <= page || !sparse_[page]) {
+            return false;
+        }
+        return sparse_[page]->at(offset) != 0 ||
+               key_traits::index(dense_.front().first) == key_traits::index(key);
     }
 
     /**
@@ -368,23 +858,28 @@ private:
      * We could check before calling this.
      */
     auto erase_without_check_impl(const size_type page, const size_type offset) {
-        unique_lock_keeper keeper{ dense_mutex_, sparse_mutex_ };
+        unique_lock lock{ mutex_ };
         erase_without_check_impl_unlocked(page, offset);
     }
 
     auto erase_without_check_impl_unlocked(const size_type page, const size_type offset) {
-        auto& index                                             = sparse_[page]->at(offset);
-        auto& back                                              = dense_.back();
-        sparse_[page_of(back.first)]->at(offset_of(back.first)) = index;
+        auto& slot       = sparse_[page]->at(offset);
+        const auto index = index_of_slot(slot);
+        auto& back       = dense_.back();
+        sparse_[page_of(back.first)]->at(offset_of(back.first)) = make_slot(index, back.first);
         std::swap(dense_[index], back);
         dense_.pop_back();
-        index = 0;
+        slot = 0;
+        if (--page_counts_[page] == 0) {
+            sparse_[page].reset();
+        }
     }
 
     std::vector<value_type, allocator_t<value_type>> dense_;
     std::vector<storage_t, allocator_t<storage_t>> sparse_;
-    std::shared_mutex dense_mutex_;
-    std::shared_mutex sparse_mutex_;
+    // number of keys in each page, a page is released once it drops to zero.
+    std::vector<size_type, allocator_t<size_type>> page_counts_;
+    [[no_unique_address]] mutable Mutex mutex_;
 };
 
 #if _HAS_CXX17
@@ -1,7 +1,10 @@
 #pragma once
+#include <array>
 #include <concepts>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <utility>
 #include <vector>
 #include "core.hpp"
 #include "core/pair.hpp"
@@ -9,9 +12,12 @@
 #include "memory/allocator.hpp"
 #include "memory/storage.hpp"
 #include "structures.hpp"
+#include "thread/lock.hpp"
 
 namespace atom::utils {
-template <std::unsigned_integral Ty, typename Alloc, std::size_t PageSize>
+template <
+    std::unsigned_integral Ty, typename Alloc, std::size_t PageSize, typename Mutex,
+    bool InlinePages>
 class dense_set {
     template <typename Target>
     using allocator_t = typename ::atom::utils::rebind_allocator<Alloc>::template to<Target>::type;
@@ -20,6 +26,7 @@ class dense_set {
     using alty_traits = std::allocator_traits<alty>;
 
 public:
+    using key_type        = Ty;
     using value_type      = Ty;
     using pointer         = typename alty_traits::pointer;
     using const_pointer   = typename alty_traits::const_pointer;
@@ -28,17 +35,21 @@ public:
     using size_type       = typename alty_traits::size_type;
     using difference_type = typename alty_traits::difference_type;
     using allocator_type  = allocator_t<value_type>;
+    using mutex_type      = Mutex;
 
     using iterator = typename std::vector<value_type, allocator_t<value_type>>::iterator;
     using const_iterator =
         typename std::vector<value_type, allocator_t<value_type>>::const_iterator;
 
 private:
-    using array_t   = std::array<size_type, PageSize>;
-    using storage_t = ::atom::utils::unique_storage<array_t, allocator_t<array_t>>;
+    using array_t     = std::array<size_type, PageSize>;
+    using storage_t   = ::atom::utils::unique_storage<
+          array_t, allocator_t<array_t>, InlinePages ? sizeof(array_t) : 0>;
+    using shared_lock = ::atom::utils::internal::shared_guard_t<Mutex>;
+    using unique_lock = ::atom::utils::internal::unique_guard_t<Mutex>;
 
 public:
-    dense_set() : dense_(), sparse_(), dense_mutex_(), sparse_mutex_() {}
+    dense_set() : dense_(), sparse_() {}
 
     template <typename Al>
     requires std::is_constructible_v<allocator_t<value_type>, Al> &&
@@ -48,41 +59,189 @@ public:
     template <typename Al>
     dense_set(std::allocator_arg_t, const Al& alloc) : dense_(alloc), sparse_(alloc) {}
 
-    dense_set(const dense_set&) = default;
+    dense_set(const dense_set& that) : dense_(that.dense_), sparse_(that.sparse_.get_allocator()) {
+        sparse_.reserve(that.sparse_.size());
+        for (const auto& page : that.sparse_) {
+            storage_t storage{ std::allocator_arg, dense_.get_allocator() };
+            storage = *page;
+            sparse_.emplace_back(std::move(storage));
+        }
+    }
 
-    dense_set(dense_set&& that) noexcept : dense_(std::move(that.dense_)), sparse_(that.sparse_) {}
+    dense_set(dense_set&& that) noexcept
+        : dense_(std::move(that.dense_)), sparse_(std::move(that.sparse_)) {}
 
-    dense_set& operator=(const dense_set&) = default;
+    dense_set& operator=(const dense_set& that) {
+        if (this != &that) {
+            dense_set temp(that);
+            std::swap(dense_, temp.dense_);
+            std::swap(sparse_, temp.sparse_);
+        }
+        return *this;
+    }
 
     dense_set& operator=(dense_set&& that) noexcept {
         if (this != &that) [[likely]] {
+            std::scoped_lock lock{ mutex_, that.mutex_ };
             dense_  = std::move(that.dense_);
             sparse_ = std::move(that.sparse_);
         }
         return *this;
     }
 
-    ~dense_set();
+    ~dense_set() = default;
 
-    bool contains(const value_type val) const noexcept {}
+    bool contains(const value_type val) const noexcept {
+        shared_lock lock{ mutex_ };
+        return contains_impl(val, page_of(val), offset_of(val));
+    }
 
     template <typename... Args>
     requires std::is_constructible_v<value_type, Args...>
-    void emplace(Args&&... args) {}
+    void emplace(Args&&... args) {
+        const value_type val(std::forward<Args>(args)...);
+        const auto page   = page_of(val);
+        const auto offset = offset_of(val);
+
+        unique_lock lock{ mutex_ };
+        if (contains_impl(val, page, offset)) {
+            return;
+        }
+
+        const auto current_page_count = sparse_.size();
+        check_page(page);
+        try {
+            dense_.emplace_back(val);
+        }
+        catch (...) {
+            pop_page_to(current_page_count);
+            throw;
+        }
+        sparse_[page]->at(offset) = dense_.size() - 1;
+    }
+
+    [[nodiscard]] iterator find(const value_type val) noexcept {
+        shared_lock lock{ mutex_ };
+        const auto page   = page_of(val);
+        const auto offset = offset_of(val);
+        return contains_impl(val, page, offset) ? dense_.begin() + sparse_[page]->at(offset)
+                                                : dense_.end();
+    }
+
+    [[nodiscard]] const_iterator find(const value_type val) const noexcept {
+        shared_lock lock{ mutex_ };
+        const auto page   = page_of(val);
+        const auto offset = offset_of(val);
+        return contains_impl(val, page, offset) ? dense_.cbegin() + sparse_[page]->at(offset)
+                                                : dense_.cend();
+    }
+
+    /**
+     * @brief Erase the value by moving the last value into its place.
+     *
+     * @return Iterator to the element that took the place of the erased one.
+     */
+    const_iterator erase(const value_type val) noexcept {
+        const auto page   = page_of(val);
+        const auto offset = offset_of(val);
+
+        unique_lock lock{ mutex_ };
+        if (!contains_impl(val, page, offset)) {
+            return dense_.cend();
+        }
+        const auto index = sparse_[page]->at(offset);
+        erase_without_check_unlocked(page, offset);
+        return dense_.cbegin() + index;
+    }
+
+    const_iterator erase(const_iterator iter) noexcept { return erase(*iter); }
 
-    [[nodiscard]] iterator find(const value_type val) noexcept {}
+    void reserve(const size_type size) {
+        unique_lock lock{ mutex_ };
+        check_page(page_of(size));
+        dense_.reserve(size);
+    }
+
+    void clear() noexcept {
+        unique_lock lock{ mutex_ };
+        sparse_.clear();
+        dense_.clear();
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return dense_.empty(); }
+
+    [[nodiscard]] size_type size() const noexcept { return dense_.size(); }
 
-    [[nodiscard]] const_iterator find(const value_type val) const noexcept {}
+    [[nodiscard]] iterator begin() noexcept { return dense_.begin(); }
+    [[nodiscard]] const_iterator begin() const noexcept { return dense_.begin(); }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return dense_.cbegin(); }
 
-    const_iterator erase(const value_type val) noexcept {}
+    [[nodiscard]] iterator end() noexcept { return dense_.end(); }
+    [[nodiscard]] const_iterator end() const noexcept { return dense_.end(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return dense_.cend(); }
 
-    const_iterator erase(const_iterator iter) noexcept {}
+    [[nodiscard]] auto get_allocator() const noexcept { return dense_.get_allocator(); }
 
 private:
+    template <typename...>
+    friend class join_view;
+
+    static size_type page_of(const value_type val) noexcept { return val / PageSize; }
+    static size_type offset_of(const value_type val) noexcept { return val % PageSize; }
+
+    void check_page(const size_type page) {
+        const auto current_page = sparse_.size();
+        try {
+            while (page >= sparse_.size()) {
+                storage_t storage{ std::allocator_arg, dense_.get_allocator(), construct_at_once };
+                sparse_.emplace_back(std::move(storage));
+            }
+        }
+        catch (...) {
+            pop_page_to(current_page);
+            throw;
+        }
+    }
+
+    void pop_page_to(const size_type page) noexcept {
+        while (sparse_.size() != page) {
+            sparse_.pop_back();
+        }
+    }
+
+    /**
+     * @brief Index 0 is also the value of empty slots, so it is checked against the dense array.
+     *
+     */
+    [[nodiscard]] bool contains_impl(
+        const value_type val, const size_type page, const size_type offset) const noexcept {
+        if (dense_.empty() || sparse_.size() <= page) {
+            return false;
+        }
+        const auto index = sparse_[page]->at(offset);
+        return index != 0 || dense_.front() == val;
+    }
+
+    /**
+     * @brief Whether the value exists. The caller holds the lock.
+     *
+     */
+    [[nodiscard]] bool probe_unlocked(const value_type val) const noexcept {
+        return contains_impl(val, page_of(val), offset_of(val));
+    }
+
+    void erase_without_check_unlocked(const size_type page, const size_type offset) noexcept {
+        auto& index                                 = sparse_[page]->at(offset);
+        const auto back                             = dense_.back();
+        sparse_[page_of(back)]->at(offset_of(back)) = index;
+        dense_[index]                               = back;
+        dense_.pop_back();
+        index = 0;
+    }
+
     std::vector<value_type, allocator_type> dense_;
     std::vector<storage_t, allocator_t<storage_t>> sparse_;
-    std::shared_mutex dense_mutex_;
-    std::shared_mutex sparse_mutex_;
+    [[no_unique_address]] mutable Mutex mutex_;
 };
 
 } // namespace atom::utils
@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "structures.hpp"
+#include "thread/lock.hpp"
+#include "thread/parallel.hpp"
+#include "thread/thread_pool.hpp"
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief References a joined container contributes to each element, maps give their value and
+ * sets only filter.
+ *
+ */
+template <typename Probe>
+struct join_refs {
+    using type = std::tuple<>;
+
+    static auto get(Probe) noexcept -> type { return {}; }
+};
+
+template <typename Ty>
+struct join_refs<Ty*> {
+    using type = std::tuple<Ty&>;
+
+    static auto get(Ty* ptr) noexcept -> type { return type{ *ptr }; }
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Joins `dense_map`s and `dense_set`s on their keys.
+ *
+ * The smallest container is walked through its dense array and the others are probed through
+ * their sparse pages, so each key costs one slot load per container. Elements are tuples of the
+ * key followed by a reference to the value of every map; sets take part in the join without
+ * adding an element.
+ *
+ * Iterating with `begin()` and `end()` takes no lock, as iterating a single container does.
+ * `each` and `parallel_each` take a shared lock of every container once for the whole loop.
+ * @tparam Containers Distinct containers sharing the key type, possibly const.
+ */
+template <typename... Containers>
+class join_view {
+    static_assert(sizeof...(Containers) != 0, "Nothing to join");
+
+    using first_container = std::remove_const_t<std::tuple_element_t<0, std::tuple<Containers...>>>;
+
+    template <typename Container>
+    using probe_t = decltype(std::declval<Container&>().probe_unlocked(
+        std::declval<typename first_container::key_type>()));
+
+public:
+    using key_type  = typename first_container::key_type;
+    using size_type = std::size_t;
+    using value_type =
+        decltype(std::tuple_cat(
+            std::declval<std::tuple<key_type>>(),
+            std::declval<typename internal::join_refs<probe_t<Containers>>::type>()...));
+
+    static_assert(
+        (std::is_same_v<key_type, typename Containers::key_type> && ...),
+        "Containers in a join should share the key type");
+
+    constexpr static size_type k_default_grain = k_default_parallel_grain;
+
+    class iterator {
+    public:
+        using iterator_concept  = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = join_view::value_type;
+        using reference         = join_view::value_type;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+
+        iterator(join_view* view, const size_type lead, const size_type position) noexcept
+            : view_(view), lead_(lead), position_(position) {
+            settle();
+        }
+
+        [[nodiscard]] auto operator*() const -> reference {
+            return view_->value_of(view_->key_at(lead_, position_));
+        }
+
+        iterator& operator++() noexcept {
+            ++position_;
+            settle();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            auto temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        [[nodiscard]] bool operator==(const iterator& that) const noexcept {
+            return position_ == that.position_;
+        }
+
+    private:
+        void settle() noexcept {
+            const auto last = view_->size_of(lead_);
+            while (position_ < last && !view_->matches(view_->key_at(lead_, position_))) {
+                ++position_;
+            }
+        }
+
+        join_view* view_{};
+        size_type lead_{};
+        size_type position_{};
+    };
+
+    explicit join_view(Containers&... containers) noexcept : containers_(containers...) {}
+
+    [[nodiscard]] auto begin() noexcept -> iterator { return iterator{ this, lead(), 0 }; }
+
+    [[nodiscard]] auto end() noexcept -> iterator {
+        const auto index = lead();
+        return iterator{ this, index, size_of(index) };
+    }
+
+    /**
+     * @brief Upper bound of the number of elements, the size of the smallest container.
+     *
+     */
+    [[nodiscard]] auto size_hint() const noexcept -> size_type { return size_of(lead()); }
+
+    /**
+     * @brief Call `func(key, values...)` for every key found in all containers.
+     *
+     */
+    template <typename Func>
+    void each(Func&& func) {
+        auto locks       = lock_all();
+        const auto index = lead();
+        each_in(index, func, 0, size_of(index));
+    }
+
+    /**
+     * @brief Same as `each`, but the smallest container is split into chunks run on the pool.
+     *
+     * The calling thread runs the first chunk itself and returns once every chunk is done.
+     * @param func Called concurrently from several threads.
+     * @param grain Number of positions of the smallest container in each chunk.
+     */
+    template <typename Func>
+    void parallel_each(thread_pool& pool, Func&& func, const size_type grain = k_default_grain) {
+        auto locks       = lock_all();
+        const auto index = lead();
+        const auto step  = std::max<size_type>(grain, 1);
+
+        auto chunk = [this, &func, index](const size_type first, const size_type last) {
+            each_in(index, func, first, last);
+        };
+        internal::run_chunks(pool, size_of(index), step, step, chunk);
+    }
+
+private:
+    [[nodiscard]] auto lock_all() const {
+        return std::apply(
+            [](auto&... containers) {
+                return std::tuple<internal::shared_guard_t<
+                    typename std::remove_cvref_t<decltype(containers)>::mutex_type>...>{
+                    containers.mutex_...
+                };
+            },
+            containers_);
+    }
+
+    [[nodiscard]] auto lead() const noexcept -> size_type {
+        return std::apply(
+            [](const auto&... containers) {
+                const std::array<size_type, sizeof...(Containers)> sizes{ containers.size()... };
+                return static_cast<size_type>(std::ranges::min_element(sizes) - sizes.begin());
+            },
+            containers_);
+    }
+
+    [[nodiscard]] auto size_of(const size_type lead) const noexcept -> size_type {
+        size_type size{};
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((lead == Is ? (size = std::get<Is>(containers_).size(), true) : false) || ...);
+        }(std::index_sequence_for<Containers...>{});
+        return size;
+    }
+
+    template <typename Elem>
+    [[nodiscard]] static auto key_of(const Elem& elem) noexcept -> key_type {
+        if constexpr (std::is_convertible_v<const Elem&, key_type>) {
+            return elem;
+        }
+        else {
+            return elem.first;
+        }
+    }
+
+    [[nodiscard]] auto key_at(const size_type lead, const size_type position) const noexcept
+        -> key_type {
+        key_type key{};
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((lead == Is ? (key = key_of(std::get<Is>(containers_).begin()[position]), true)
+                         : false) ||
+             ...);
+        }(std::index_sequence_for<Containers...>{});
+        return key;
+    }
+
+    [[nodiscard]] auto probe(const key_type key) const noexcept {
+        return std::apply(
+            [key](auto&... containers) {
+                return std::tuple<probe_t<Containers>...>{ containers.probe_unlocked(key)... };
+            },
+            containers_);
+    }
+
+    /**
+     * @brief Probe every container but the walked one, whose element is already at hand.
+     *
+     */
+    template <std::size_t Lead, typename Elem>
+    [[nodiscard]] auto probe_from(const key_type key, Elem& elem) const noexcept {
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::tuple<probe_t<Containers>...>{ probe_one<Is, Lead>(key, elem)... };
+        }(std::index_sequence_for<Containers...>{});
+    }
+
+    template <std::size_t Index, std::size_t Lead, typename Elem>
+    [[nodiscard]] auto probe_one(const key_type key, Elem& elem) const noexcept {
+        using probe_type = probe_t<std::tuple_element_t<Index, std::tuple<Containers...>>>;
+        if constexpr (Index != Lead) {
+            return std::get<Index>(containers_).probe_unlocked(key);
+        }
+        else if constexpr (std::is_pointer_v<probe_type>) {
+            return probe_type{ &elem.second };
+        }
+        else {
+            return probe_type{ true };
+        }
+    }
+
+    template <typename Probes>
+    [[nodiscard]] static auto found(const Probes& probes) noexcept -> bool {
+        return std::apply(
+            [](const auto&... probe) { return (static_cast<bool>(probe) && ...); }, probes);
+    }
+
+    template <typename Probes>
+    [[nodiscard]] static auto make_value(const key_type key, const Probes& probes) noexcept
+        -> value_type {
+        return std::apply(
+            [key](const auto&... probe) {
+                return std::tuple_cat(
+                    std::tuple<key_type>{ key },
+                    internal::join_refs<std::remove_cvref_t<decltype(probe)>>::get(probe)...);
+            },
+            probes);
+    }
+
+    [[nodiscard]] auto matches(const key_type key) const noexcept -> bool {
+        return found(probe(key));
+    }
+
+    [[nodiscard]] auto value_of(const key_type key) const noexcept -> value_type {
+        return make_value(key, probe(key));
+    }
+
+    template <typename Func>
+    void each_in(const size_type lead, Func& func, const size_type first, const size_type last) {
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((lead == Is ? (each_from<Is>(func, first, last), true) : false) || ...);
+        }(std::index_sequence_for<Containers...>{});
+    }
+
+    /**
+     * @brief The loop itself, with the walked container known at compile time.
+     *
+     */
+    template <std::size_t Lead, typename Func>
+    void each_from(Func& func, const size_type first, const size_type last) {
+        auto iter = std::get<Lead>(containers_).begin();
+        for (size_type position = first; position < last; ++position) {
+            auto&& elem       = iter[position];
+            const auto key    = key_of(elem);
+            const auto probes = probe_from<Lead>(key, elem);
+            if (found(probes)) {
+                std::apply(func, make_value(key, probes));
+            }
+        }
+    }
+
+    std::tuple<Containers&...> containers_;
+};
+
+/**
+ * @brief Join dense containers on their keys.
+ *
+ */
+template <typename... Containers>
+[[nodiscard]] auto join(Containers&... containers) noexcept -> join_view<Containers...> {
+    return join_view<Containers...>{ containers... };
+}
+
+} // namespace atom::utils
@@ -13,10 +13,10 @@ template <typename Ty>
 using sync_vector = std::vector<Ty, sync_allocator<Ty>>;
 
 template <typename Ty>
-using sync_list = std::list<Ty, sync_allocator<Ty>>;
+using sync_list = std::list<Ty, sync_node_allocator<Ty>>;
 
 template <typename Ty>
-using sync_forward_list = std::forward_list<Ty, sync_allocator<Ty>>;
+using sync_forward_list = std::forward_list<Ty, sync_node_allocator<Ty>>;
 
 template <typename Ty>
 using sync_deque = std::deque<Ty, sync_allocator<Ty>>;
@@ -36,10 +36,10 @@ template <typename Ty>
 using unsync_vector = std::vector<Ty, unsync_allocator<Ty>>;
 
 template <typename Ty>
-using unsync_list = std::list<Ty, unsync_allocator<Ty>>;
+using unsync_list = std::list<Ty, unsync_node_allocator<Ty>>;
 
 template <typename Ty>
-using unsync_forward_list = std::forward_list<Ty, unsync_allocator<Ty>>;
+using unsync_forward_list = std::forward_list<Ty, unsync_node_allocator<Ty>>;
 
 template <typename Ty>
 using unsync_deque = std::deque<Ty, unsync_allocator<Ty>>;
@@ -0,0 +1,386 @@
+#pragma once
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "core.hpp"
+#include "core/langdef.hpp"
+#include "memory/allocator.hpp"
+#include "memory/storage.hpp"
+#include "structures.hpp"
+#include "thread/lock.hpp"
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Iterator over parallel key and value arrays, yields pairs of references.
+ *
+ */
+template <typename Key, typename Val>
+class soa_iterator {
+public:
+    using iterator_concept  = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = std::pair<std::remove_const_t<Key>, std::remove_const_t<Val>>;
+    using reference         = std::pair<Key&, Val&>;
+    using difference_type   = std::ptrdiff_t;
+
+    constexpr soa_iterator() noexcept = default;
+
+    constexpr soa_iterator(Key* keys, Val* values) noexcept : keys_(keys), values_(values) {}
+
+    template <typename K, typename V>
+    requires std::is_convertible_v<K*, Key*> && std::is_convertible_v<V*, Val*>
+    constexpr soa_iterator(const soa_iterator<K, V>& that) noexcept
+        : keys_(that.keys_), values_(that.values_) {}
+
+    [[nodiscard]] constexpr auto operator*() const noexcept -> reference {
+        return { *keys_, *values_ };
+    }
+
+    [[nodiscard]] constexpr auto operator[](const difference_type offset) const noexcept
+        -> reference {
+        return { keys_[offset], values_[offset] };
+    }
+
+    constexpr soa_iterator& operator++() noexcept {
+        ++keys_;
+        ++values_;
+        return *this;
+    }
+
+    constexpr soa_iterator operator++(int) noexcept {
+        auto temp = *this;
+        ++*this;
+        return temp;
+    }
+
+    constexpr soa_iterator& operator--() noexcept {
+        --keys_;
+        --values_;
+        return *this;
+    }
+
+    constexpr soa_iterator operator--(int) noexcept {
+        auto temp = *this;
+        --*this;
+        return temp;
+    }
+
+    constexpr soa_iterator& operator+=(const difference_type offset) noexcept {
+        keys_ += offset;
+        values_ += offset;
+        return *this;
+    }
+
+    constexpr soa_iterator& operator-=(const difference_type offset) noexcept {
+        return *this += -offset;
+    }
+
+    [[nodiscard]] constexpr soa_iterator operator+(const difference_type offset) const noexcept {
+        auto temp = *this;
+        return temp += offset;
+    }
+
+    [[nodiscard]] friend constexpr soa_iterator operator+(
+        const difference_type offset, const soa_iterator& iter) noexcept {
+        return iter + offset;
+    }
+
+    [[nodiscard]] constexpr soa_iterator operator-(const difference_type offset) const noexcept {
+        auto temp = *this;
+        return temp -= offset;
+    }
+
+    [[nodiscard]] constexpr difference_type operator-(const soa_iterator& that) const noexcept {
+        return keys_ - that.keys_;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const soa_iterator& that) const noexcept {
+        return keys_ == that.keys_;
+    }
+
+    [[nodiscard]] constexpr auto operator<=>(const soa_iterator& that) const noexcept {
+        return keys_ <=> that.keys_;
+    }
+
+private:
+    template <typename, typename>
+    friend class soa_iterator;
+
+    Key* keys_{};
+    Val* values_{};
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Dense map storing keys and values in two parallel arrays.
+ *
+ * Looking up is the same as `dense_map`, but `keys()` and `values()` are contiguous spans, so a
+ * loop over only the values streams through memory without touching the keys and can be
+ * vectorized by the compiler.
+ */
+template <
+    std::unsigned_integral Key, typename Val, typename Alloc, std::size_t PageSize, typename Mutex>
+class soa_dense_map {
+    template <typename Target>
+    using allocator_t = typename rebind_allocator<Alloc>::template to<Target>::type;
+
+    using alty        = allocator_t<Val>;
+    using alty_traits = std::allocator_traits<alty>;
+
+public:
+    using key_type        = Key;
+    using mapped_type     = Val;
+    using value_type      = std::pair<key_type, mapped_type>;
+    using size_type       = typename alty_traits::size_type;
+    using difference_type = typename alty_traits::difference_type;
+    using mutex_type      = Mutex;
+
+    using iterator       = internal::soa_iterator<const key_type, mapped_type>;
+    using const_iterator = internal::soa_iterator<const key_type, const mapped_type>;
+
+private:
+    using array_t     = std::array<size_type, PageSize>;
+    using storage_t   = ::atom::utils::unique_storage<array_t, allocator_t<array_t>>;
+    using shared_lock = ::atom::utils::internal::shared_guard_t<Mutex>;
+    using unique_lock = ::atom::utils::internal::unique_guard_t<Mutex>;
+
+public:
+    soa_dense_map() : keys_(), values_(), sparse_() {}
+
+    template <typename Al>
+    explicit soa_dense_map(const Al& al) : keys_(al), values_(al), sparse_(al) {}
+
+    template <typename Al>
+    soa_dense_map(std::allocator_arg_t, const Al& al) : soa_dense_map(al) {}
+
+    soa_dense_map(std::initializer_list<value_type> il) : soa_dense_map() {
+        reserve(il.size());
+        for (const auto& [key, val] : il) {
+            emplace_unlocked(key, val);
+        }
+    }
+
+    soa_dense_map(const soa_dense_map& that)
+        : keys_(that.keys_), values_(that.values_), sparse_(that.sparse_.get_allocator()) {
+        sparse_.reserve(that.sparse_.size());
+        for (const auto& page : that.sparse_) {
+            storage_t storage{ std::allocator_arg, values_.get_allocator() };
+            storage = *page;
+            sparse_.emplace_back(std::move(storage));
+        }
+    }
+
+    soa_dense_map(soa_dense_map&& that) noexcept
+        : keys_(std::move(that.keys_)), values_(std::move(that.values_)),
+          sparse_(std::move(that.sparse_)) {}
+
+    soa_dense_map& operator=(const soa_dense_map& that) {
+        if (this != &that) {
+            soa_dense_map temp(that);
+            std::swap(keys_, temp.keys_);
+            std::swap(values_, temp.values_);
+            std::swap(sparse_, temp.sparse_);
+        }
+        return *this;
+    }
+
+    soa_dense_map& operator=(soa_dense_map&& that) noexcept {
+        if (this != &that) {
+            std::scoped_lock lock{ mutex_, that.mutex_ };
+            keys_   = std::move(that.keys_);
+            values_ = std::move(that.values_);
+            sparse_ = std::move(that.sparse_);
+        }
+        return *this;
+    }
+
+    ~soa_dense_map() noexcept = default;
+
+    _NODISCARD auto at(const key_type key) -> mapped_type& {
+        shared_lock lock{ mutex_ };
+        return values_[sparse_[page_of(key)]->at(offset_of(key))];
+    }
+
+    _NODISCARD auto at(const key_type key) const -> const mapped_type& {
+        shared_lock lock{ mutex_ };
+        return values_[sparse_[page_of(key)]->at(offset_of(key))];
+    }
+
+    auto operator[](const key_type key) -> mapped_type& { return at(key); }
+
+    /**
+     * @brief Construct the mapped value in place if the key does not exist.
+     *
+     * @return Iterator to the element with the key, and whether it was inserted.
+     */
+    template <typename... Args>
+    requires std::is_constructible_v<mapped_type, Args...>
+    auto emplace(const key_type key, Args&&... args) -> std::pair<iterator, bool> {
+        unique_lock lock{ mutex_ };
+        return emplace_unlocked(key, std::forward<Args>(args)...);
+    }
+
+    auto erase(const key_type key) -> bool {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+
+        unique_lock lock{ mutex_ };
+        if (!contains_impl(key, page, offset)) {
+            return false;
+        }
+
+        auto& index     = sparse_[page]->at(offset);
+        const auto back = keys_.back();
+        if (index != keys_.size() - 1) {
+            sparse_[page_of(back)]->at(offset_of(back)) = index;
+            keys_[index]                                = back;
+            values_[index]                              = std::move(values_.back());
+        }
+        keys_.pop_back();
+        values_.pop_back();
+        index = 0;
+        return true;
+    }
+
+    void reserve(const size_type size) {
+        unique_lock lock{ mutex_ };
+        check_page(page_of(size));
+        keys_.reserve(size);
+        values_.reserve(size);
+    }
+
+    [[nodiscard]] auto contains(const key_type key) const -> bool {
+        shared_lock lock{ mutex_ };
+        return contains_impl(key, page_of(key), offset_of(key));
+    }
+
+    [[nodiscard]] auto find(const key_type key) noexcept -> iterator {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        shared_lock lock{ mutex_ };
+        return contains_impl(key, page, offset) ? begin() + sparse_[page]->at(offset) : end();
+    }
+
+    [[nodiscard]] auto find(const key_type key) const noexcept -> const_iterator {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        shared_lock lock{ mutex_ };
+        return contains_impl(key, page, offset) ? begin() + sparse_[page]->at(offset) : end();
+    }
+
+    void clear() noexcept {
+        unique_lock lock{ mutex_ };
+        sparse_.clear();
+        keys_.clear();
+        values_.clear();
+    }
+
+    /**
+     * @brief Contiguous keys, in the same order as `values()`.
+     *
+     */
+    [[nodiscard]] auto keys() const noexcept -> std::span<const key_type> { return keys_; }
+
+    /**
+     * @brief Contiguous values, in the same order as `keys()`.
+     *
+     */
+    [[nodiscard]] auto values() noexcept -> std::span<mapped_type> { return values_; }
+    [[nodiscard]] auto values() const noexcept -> std::span<const mapped_type> { return values_; }
+
+    _NODISCARD bool empty() const noexcept { return keys_.empty(); }
+
+    _NODISCARD size_type size() const noexcept { return keys_.size(); }
+
+    _NODISCARD auto begin() noexcept -> iterator { return { keys_.data(), values_.data() }; }
+    _NODISCARD auto begin() const noexcept -> const_iterator {
+        return { keys_.data(), values_.data() };
+    }
+    _NODISCARD auto cbegin() const noexcept -> const_iterator { return begin(); }
+
+    _NODISCARD auto end() noexcept -> iterator { return begin() + keys_.size(); }
+    _NODISCARD auto end() const noexcept -> const_iterator { return begin() + keys_.size(); }
+    _NODISCARD auto cend() const noexcept -> const_iterator { return end(); }
+
+    _NODISCARD auto get_allocator() const noexcept { return values_.get_allocator(); }
+
+private:
+    static size_type page_of(const key_type key) noexcept { return key / PageSize; }
+    static size_type offset_of(const key_type key) noexcept { return key % PageSize; }
+
+    void check_page(const size_type page) {
+        const auto current_page = sparse_.size();
+        try {
+            while (page >= sparse_.size()) {
+                storage_t storage{ std::allocator_arg, values_.get_allocator(), construct_at_once };
+                sparse_.emplace_back(std::move(storage));
+            }
+        }
+        catch (...) {
+            pop_page_to(current_page);
+            throw;
+        }
+    }
+
+    void pop_page_to(const size_type page) noexcept {
+        while (sparse_.size() != page) {
+            sparse_.pop_back();
+        }
+    }
+
+    [[nodiscard]] auto contains_impl(
+        const key_type key, const size_type page, const size_type offset) const noexcept -> bool {
+        if (keys_.empty() || sparse_.size() <= page) {
+            return false;
+        }
+        return sparse_[page]->at(offset) != 0 || keys_.front() == key;
+    }
+
+    template <typename... Args>
+    auto emplace_unlocked(const key_type key, Args&&... args) -> std::pair<iterator, bool> {
+        const auto page   = page_of(key);
+        const auto offset = offset_of(key);
+        if (contains_impl(key, page, offset)) {
+            return { begin() + sparse_[page]->at(offset), false };
+        }
+
+        const auto current_page_count = sparse_.size();
+        check_page(page);
+        try {
+            keys_.emplace_back(key);
+            try {
+                values_.emplace_back(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                keys_.pop_back();
+                throw;
+            }
+        }
+        catch (...) {
+            pop_page_to(current_page_count);
+            throw;
+        }
+        sparse_[page]->at(offset) = keys_.size() - 1;
+        return { end() - 1, true };
+    }
+
+    std::vector<key_type, allocator_t<key_type>> keys_;
+    std::vector<mapped_type, allocator_t<mapped_type>> values_;
+    std::vector<storage_t, allocator_t<storage_t>> sparse_;
+    [[no_unique_address]] mutable Mutex mutex_;
+};
+
+} // namespace atom::utils
@@ -10,6 +10,8 @@
 
 namespace atom::utils {
 
+class null_lock;
+
 class spin_lock;
 
 class thread_pool;
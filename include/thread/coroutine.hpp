@@ -1,21 +1,250 @@
 #pragma once
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
+#include "thread/lock.hpp"
+#include "thread/task.hpp"
+#include "thread/thread_pool.hpp"
 
 namespace atom::utils {
 
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Stored after every pooled coroutine frame, frees it the way it was allocated.
+ *
+ */
+struct frame_trailer {
+    void (*deallocate)(void* frame, std::size_t size) noexcept;
+};
+
+/**
+ * @brief Unit in which frames are requested from an allocator, aligned as `operator new` aligns.
+ *
+ */
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_block {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    std::byte bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+};
+
+constexpr auto align_frame_offset(const std::size_t offset, const std::size_t align) noexcept
+    -> std::size_t {
+    return (offset + align - 1) / align * align;
+}
+
+/**
+ * @brief Frames freed on a thread, kept for the next coroutines started on it.
+ *
+ * Frames are classed by `k_granularity` bytes up to `k_granularity * k_classes`, and at most
+ * `k_depth` of each class are kept. Larger frames always go to `operator new`. A frame freed on
+ * another thread than the one which allocated it joins the cache of the thread freeing it.
+ */
+class frame_cache {
+public:
+    constexpr static std::size_t k_granularity = 64;
+    constexpr static std::size_t k_classes     = 16;
+    constexpr static std::size_t k_depth       = 16;
+
+    frame_cache() noexcept = default;
+
+    frame_cache(const frame_cache&)            = delete;
+    frame_cache(frame_cache&&)                 = delete;
+    frame_cache& operator=(const frame_cache&) = delete;
+    frame_cache& operator=(frame_cache&&)      = delete;
+
+    ~frame_cache() {
+        exited() = true;
+        for (auto* head : heads_) {
+            while (head != nullptr) {
+                ::operator delete(std::exchange(head, head->next));
+            }
+        }
+    }
+
+    /**
+     * @brief Cache of the current thread, or nullptr once it is destroyed at thread exit.
+     *
+     * Static objects of the main thread are destroyed after its thread-local ones, and may still
+     * start or destroy coroutines.
+     */
+    static auto local() noexcept -> frame_cache* {
+        if (exited()) [[unlikely]] {
+            return nullptr;
+        }
+        thread_local frame_cache cache;
+        return &cache;
+    }
+
+    [[nodiscard]] auto allocate(const std::size_t bytes) -> void* {
+        const auto index = class_of(bytes);
+        if (index >= k_classes) {
+            return ::operator new(bytes);
+        }
+        if (auto* const frame = heads_[index]) {
+            heads_[index] = frame->next;
+            --counts_[index];
+            return frame;
+        }
+        return ::operator new((index + 1) * k_granularity);
+    }
+
+    void deallocate(void* const frame, const std::size_t bytes) noexcept {
+        const auto index = class_of(bytes);
+        if (index >= k_classes || counts_[index] == k_depth) {
+            ::operator delete(frame);
+            return;
+        }
+        heads_[index] = ::new (frame) free_frame{ heads_[index] };
+        ++counts_[index];
+    }
+
+private:
+    struct free_frame {
+        free_frame* next;
+    };
+
+    [[nodiscard]] constexpr static auto class_of(const std::size_t bytes) noexcept
+        -> std::size_t {
+        return (bytes - 1) / k_granularity;
+    }
+
+    // trivially destructible, so it is still readable after the cache is gone.
+    static auto exited() noexcept -> bool& {
+        thread_local bool flag{};
+        return flag;
+    }
+
+    std::array<free_frame*, k_classes> heads_{};
+    std::array<std::size_t, k_classes> counts_{};
+};
+
+/**
+ * @brief Allocation functions of a promise type whose frames avoid the global heap.
+ *
+ * A coroutine whose parameters start with `std::allocator_arg_t` and an allocator, after the
+ * object for a member function, gets its frame from that allocator, which may be one of the
+ * allocators of the `atom::utils` pools. A copy of it, rebound to `frame_block`, is kept after
+ * the frame to free it. Any other frame comes from the `frame_cache` of the calling thread.
+ */
+struct pooled_frame {
+    static auto operator new(const std::size_t size) -> void* {
+        const auto offset = trailer_offset(size);
+        const auto bytes  = offset + sizeof(frame_trailer);
+        if (auto* const cache = frame_cache::local()) [[likely]] {
+            auto* const frame = cache->allocate(bytes);
+            ::new (static_cast<std::byte*>(frame) + offset) frame_trailer{ &free_cached };
+            return frame;
+        }
+        // sized for `bytes` only, so it must never join the classes of a cache.
+        auto* const frame = ::operator new(bytes);
+        ::new (static_cast<std::byte*>(frame) + offset) frame_trailer{ &free_uncached };
+        return frame;
+    }
+
+    template <typename Alloc, typename... Args>
+    static auto operator new(
+        const std::size_t size, std::allocator_arg_t, const Alloc& alloc, const Args&...)
+        -> void* {
+        return allocate_with(size, alloc);
+    }
+
+    template <typename This, typename Alloc, typename... Args>
+    static auto operator new(
+        const std::size_t size, const This&, std::allocator_arg_t, const Alloc& alloc,
+        const Args&...) -> void* {
+        return allocate_with(size, alloc);
+    }
+
+    static void operator delete(void* const frame, const std::size_t size) noexcept {
+        auto* const bytes         = static_cast<std::byte*>(frame);
+        const auto* const trailer =
+            std::launder(reinterpret_cast<frame_trailer*>(bytes + trailer_offset(size)));
+        trailer->deallocate(frame, size);
+    }
+
+private:
+    [[nodiscard]] constexpr static auto trailer_offset(const std::size_t size) noexcept
+        -> std::size_t {
+        return align_frame_offset(size, alignof(frame_trailer));
+    }
+
+    template <typename Alloc>
+    [[nodiscard]] constexpr static auto allocator_offset(const std::size_t size) noexcept
+        -> std::size_t {
+        return align_frame_offset(trailer_offset(size) + sizeof(frame_trailer), alignof(Alloc));
+    }
+
+    template <typename Alloc>
+    [[nodiscard]] constexpr static auto blocks_of(const std::size_t size) noexcept
+        -> std::size_t {
+        return (allocator_offset<Alloc>(size) + sizeof(Alloc) + sizeof(frame_block) - 1) /
+               sizeof(frame_block);
+    }
+
+    static void free_cached(void* const frame, const std::size_t size) noexcept {
+        if (auto* const cache = frame_cache::local()) [[likely]] {
+            cache->deallocate(frame, trailer_offset(size) + sizeof(frame_trailer));
+            return;
+        }
+        ::operator delete(frame);
+    }
+
+    static void free_uncached(void* const frame, std::size_t) noexcept { ::operator delete(frame); }
+
+    template <typename Alloc>
+    static auto allocate_with(const std::size_t size, const Alloc& alloc) -> void* {
+        using block_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<
+            frame_block>;
+        using traits = std::allocator_traits<block_allocator>;
+
+        block_allocator allocator(alloc);
+        auto* const bytes = reinterpret_cast<std::byte*>(
+            std::to_address(traits::allocate(allocator, blocks_of<block_allocator>(size))));
+        ::new (bytes + trailer_offset(size)) frame_trailer{ &free_with<block_allocator> };
+        ::new (bytes + allocator_offset<block_allocator>(size))
+            block_allocator(std::move(allocator));
+        return bytes;
+    }
+
+    template <typename Alloc>
+    static void free_with(void* const frame, const std::size_t size) noexcept {
+        using traits = std::allocator_traits<Alloc>;
+
+        auto& stored = *std::launder(reinterpret_cast<Alloc*>(
+            static_cast<std::byte*>(frame) + allocator_offset<Alloc>(size)));
+        Alloc allocator(std::move(stored));
+        std::destroy_at(&stored);
+        traits::deallocate(allocator, static_cast<frame_block*>(frame), blocks_of<Alloc>(size));
+    }
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Generator-style coroutine, resumed by `get` up to its next value.
+ *
+ * Frames come from a per-thread cache of recycled frames, or from the allocator passed after
+ * `std::allocator_arg` as the first parameters of the coroutine, so short-lived generators do not
+ * reach `malloc`. Each value is moved out of the frame rather than copied.
+ */
 template <typename Ty>
 class coroutine {
 public:
     struct promise_type;
     using handle_type = std::coroutine_handle<promise_type>;
 
-    struct promise_type {
+    struct promise_type : internal::pooled_frame {
         coroutine get_return_object() { return coroutine(handle_type::from_promise(*this)); }
         std::suspend_always initial_suspend() { return {}; }
         std::suspend_always final_suspend() noexcept { return {}; }
@@ -35,7 +264,8 @@ public:
                 std::rethrow_exception(eptr_);
             }
 
-            return value_;
+            // the next resume overwrites it anyway.
+            return std::move(value_);
         }
 
     private:
@@ -75,6 +305,14 @@ private:
     handle_type handle_;
 };
 
+/**
+ * @brief Generator-style coroutine that several threads may resume.
+ *
+ * The thread calling `get` claims the coroutine with a single CAS from `suspended` to `running`,
+ * resumes it inline, copies what it yielded and publishes the new state with one store. Threads
+ * finding it running spin briefly, then sleep on the state with `std::atomic::wait`, so a resume
+ * takes no lock.
+ */
 template <typename Ty>
 class thread_safe_coroutine {
 public:
@@ -88,9 +326,8 @@ public:
     };
 
     struct promise_type {
+        // only changes through `get`, once the coroutine is really suspended.
         std::atomic<status> state{ status::suspended };
-        std::mutex mtx;
-        std::condition_variable cv;
         Ty value_;
         std::exception_ptr eptr_;
 
@@ -99,46 +336,22 @@ public:
                 handle_type::from_promise(*this), std::make_shared<control_block>(this));
         }
 
-        std::suspend_always initial_suspend() { return {}; }
-
-        auto final_suspend() noexcept {
-            struct final_awaiter : std::suspend_always {
-                promise_type& promise;
-                explicit final_awaiter(promise_type& p) : promise(p) {}
+        std::suspend_always initial_suspend() noexcept { return {}; }
 
-                bool await_ready() noexcept {
-                    std::unique_lock lk(promise.mtx);
-                    promise.state.store(status::completed);
-                    promise.cv.notify_all();
-                    return false;
-                }
-            };
-            return final_awaiter{ *this };
-        }
+        std::suspend_always final_suspend() noexcept { return {}; }
 
         template <typename T>
         std::suspend_always yield_value(T&& val) {
-            std::unique_lock lk(mtx);
             value_ = std::forward<T>(val);
-            state.store(status::suspended);
-            cv.notify_one();
             return {};
         }
 
         template <typename T>
         void return_value(T&& val) {
-            std::unique_lock lk(mtx);
             value_ = std::forward<T>(val);
-            state.store(status::completed);
-            cv.notify_all();
         }
 
-        void unhandled_exception() {
-            std::unique_lock lk(mtx);
-            eptr_ = std::current_exception();
-            state.store(status::completed);
-            cv.notify_all();
-        }
+        void unhandled_exception() { eptr_ = std::current_exception(); }
 
         Ty get() {
             if (eptr_)
@@ -150,7 +363,6 @@ public:
     struct control_block {
         promise_type* promise;
         std::atomic<int> ref_count{ 1 };
-        std::mutex mtx;
 
         explicit control_block(promise_type* p) : promise(p) {}
     };
@@ -158,64 +370,48 @@ public:
     explicit thread_safe_coroutine(handle_type h, std::shared_ptr<control_block> cb)
         : handle_(h), cb_(std::move(cb)) {}
 
-    ~thread_safe_coroutine() {
-        if (cb_) {
-            std::unique_lock lk(cb_->mtx);
-            if (--cb_->ref_count == 0) {
-                if (handle_) {
-                    handle_.destroy();
-                    handle_ = nullptr;
-                }
-            }
-        }
-    }
+    ~thread_safe_coroutine() { release(); }
 
     [[nodiscard]] bool is_ready() const noexcept {
-        return cb_ && cb_->promise->state.load() == status::suspended;
+        return cb_ && cb_->promise->state.load(std::memory_order_acquire) == status::suspended;
     }
 
     [[nodiscard]] bool done() const noexcept {
-        return !cb_ || cb_->promise->state.load() == status::completed;
+        return !cb_ || cb_->promise->state.load(std::memory_order_acquire) == status::completed;
     }
 
+    /**
+     * @brief Resume the coroutine up to its next value and return it.
+     *
+     * Once the coroutine has completed, its last value is returned, or its exception rethrown.
+     */
     Ty get() {
         if (!cb_)
             throw std::runtime_error("Coroutine object empty");
 
-        std::unique_lock lk(cb_->promise->mtx);
-        auto& state = cb_->promise->state;
-
-        // 等待协程进入可恢复状态
-        cb_->promise->cv.wait(
-            lk, [&] { return state == status::suspended || state == status::completed; });
-
-        if (state == status::completed) {
-            if (cb_->promise->eptr_) {
-                std::rethrow_exception(cb_->promise->eptr_);
-            }
-            return cb_->promise->get();
+        auto& promise = *cb_->promise;
+        auto& state   = promise.state;
+        if (!claim(state)) {
+            return promise.get();
         }
 
-        // 标记为运行状态
-        state.store(status::running);
-        lk.unlock();
-
-        handle_.resume(); // 实际恢复协程
+        handle_.resume();
 
-        lk.lock();
-        if (state == status::completed) {
-            if (cb_->promise->eptr_) {
-                std::rethrow_exception(cb_->promise->eptr_);
-            }
+        if (!handle_.done()) {
+            // copied before another thread may resume it and overwrite the value.
+            Ty value = promise.value_;
+            publish(state, status::suspended);
+            return value;
         }
-        return cb_->promise->get();
+        // nothing writes the value any more.
+        publish(state, status::completed);
+        return promise.get();
     }
 
     thread_safe_coroutine(const thread_safe_coroutine& other)
         : handle_(other.handle_), cb_(other.cb_) {
         if (cb_) {
-            std::unique_lock lk(cb_->mtx);
-            ++cb_->ref_count;
+            cb_->ref_count.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
@@ -223,15 +419,7 @@ public:
     thread_safe_coroutine& operator=(const thread_safe_coroutine& other) {
         if (this != &other) {
             // 清理当前对象资源
-            if (cb_) {
-                std::unique_lock lk(cb_->mtx);
-                if (--cb_->ref_count == 0) {
-                    if (handle_) {
-                        handle_.destroy();
-                        handle_ = nullptr;
-                    }
-                }
-            }
+            release();
 
             // 复制新资源
             handle_ = other.handle_;
@@ -239,8 +427,7 @@ public:
 
             // 增加新控制块的引用计数
             if (cb_) {
-                std::unique_lock lk(cb_->mtx);
-                ++cb_->ref_count;
+                cb_->ref_count.fetch_add(1, std::memory_order_relaxed);
             }
         }
         return *this;
@@ -254,14 +441,7 @@ public:
     thread_safe_coroutine& operator=(thread_safe_coroutine&& other) noexcept {
         if (this != &other) {
             // 清理当前对象资源
-            if (cb_) {
-                std::unique_lock lk(cb_->mtx);
-                if (--cb_->ref_count == 0) {
-                    if (handle_) {
-                        handle_.destroy();
-                    }
-                }
-            }
+            release();
 
             // 转移资源所有权
             handle_ = std::exchange(other.handle_, nullptr);
@@ -271,8 +451,381 @@ public:
     }
 
 private:
+    /**
+     * @brief Move the state from suspended to running, waiting while another thread runs it.
+     *
+     * @return False if the coroutine has completed instead.
+     */
+    static bool claim(std::atomic<status>& state) noexcept {
+        auto current = state.load(std::memory_order_acquire);
+        for (auto spin = 0;;) {
+            if (current == status::completed) {
+                return false;
+            }
+            if (current == status::suspended) {
+                if (state.compare_exchange_weak(
+                        current, status::running, std::memory_order_acquire,
+                        std::memory_order_acquire)) {
+                    return true;
+                }
+                continue;
+            }
+            if (spin < internal::max_spin_time) {
+                ++spin;
+                internal::cpu_relax();
+            }
+            else {
+                state.wait(status::running, std::memory_order_acquire);
+            }
+            current = state.load(std::memory_order_acquire);
+        }
+    }
+
+    static void publish(std::atomic<status>& state, const status next) noexcept {
+        state.store(next, std::memory_order_release);
+        state.notify_all();
+    }
+
+    void release() noexcept {
+        if (cb_ && cb_->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1 && handle_) {
+            handle_.destroy();
+        }
+        handle_ = nullptr;
+        cb_     = nullptr;
+    }
+
     handle_type handle_;
     std::shared_ptr<control_block> cb_;
 };
 
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Awaiter moving the awaiting coroutine to a worker of a `thread_pool`.
+ *
+ */
+class schedule_awaiter {
+public:
+    schedule_awaiter(thread_pool& pool, const task_hint hint) noexcept
+        : pool_(&pool), hint_(hint) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    void await_suspend(const std::coroutine_handle<> awaiting) const {
+        pool_->submit_detached(hint_, [awaiting] { awaiting.resume(); });
+    }
+
+    constexpr void await_resume() const noexcept {}
+
+private:
+    thread_pool* pool_;
+    task_hint hint_;
+};
+
+/**
+ * @brief Where a task keeps what it returned or threw.
+ *
+ */
+template <typename Ty>
+class task_result {
+public:
+    template <typename Value>
+    void return_value(Value&& value) {
+        value_.set(std::forward<Value>(value));
+    }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    auto take() -> Ty {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+        return value_.take();
+    }
+
+private:
+    task_value<Ty> value_;
+    std::exception_ptr exception_;
+};
+
+template <>
+class task_result<void> {
+public:
+    constexpr void return_void() const noexcept {}
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    void take() const {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    std::exception_ptr exception_;
+};
+
+// its address is stored as the continuation of a task once it has finished.
+inline char task_finished{};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Awaitable resuming the awaiting coroutine on a worker of `pool`.
+ *
+ * `co_await schedule_on(pool)` moves the rest of the coroutine to the pool without blocking any
+ * thread. The hint chooses the lane or the worker, as for `thread_pool::submit`.
+ */
+[[nodiscard]] inline auto schedule_on(thread_pool& pool, const task_hint hint = {}) noexcept
+    -> internal::schedule_awaiter {
+    return { pool, hint };
+}
+
+/**
+ * @brief Coroutine producing one value, which is awaited by another coroutine.
+ *
+ * A lazy task starts when it is awaited. An eager one starts when it is called and runs until it
+ * first suspends, for example on `schedule_on`, and may finish on another thread before it is
+ * awaited. Either way the awaiting coroutine is resumed by symmetric transfer from the end of the
+ * task, on the thread that finished it, so no thread blocks on a chain of tasks. Optimized builds
+ * turn the transfer into a tail call, deep chains then take no stack either.
+ *
+ * A task must be awaited at most once, and an eager task must not be dropped while it still runs.
+ * @tparam Ty Type of the result.
+ * @tparam Lazy Whether the task waits to be awaited before it starts.
+ */
+template <typename Ty, bool Lazy>
+class basic_task {
+public:
+    struct promise_type : internal::task_result<Ty> {
+        auto get_return_object() noexcept -> basic_task {
+            return basic_task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        auto initial_suspend() const noexcept {
+            if constexpr (Lazy) {
+                return std::suspend_always{};
+            }
+            else {
+                return std::suspend_never{};
+            }
+        }
+
+        auto final_suspend() const noexcept {
+            struct final_awaiter {
+                [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+                auto await_suspend(std::coroutine_handle<promise_type> self) const noexcept
+                    -> std::coroutine_handle<> {
+                    auto* const awaiting = self.promise().continuation.exchange(
+                        &internal::task_finished, std::memory_order_acq_rel);
+                    if (awaiting != nullptr) {
+                        return std::coroutine_handle<>::from_address(awaiting);
+                    }
+                    return std::noop_coroutine();
+                }
+
+                constexpr void await_resume() const noexcept {}
+            };
+            return final_awaiter{};
+        }
+
+        // the awaiting coroutine, or `task_finished` once the task is done.
+        std::atomic<void*> continuation{};
+    };
+
+    basic_task() noexcept = default;
+
+    basic_task(const basic_task&)            = delete;
+    basic_task& operator=(const basic_task&) = delete;
+
+    basic_task(basic_task&& that) noexcept : handle_(std::exchange(that.handle_, nullptr)) {}
+
+    basic_task& operator=(basic_task&& that) noexcept {
+        if (this != &that) {
+            reset();
+            handle_ = std::exchange(that.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~basic_task() { reset(); }
+
+    [[nodiscard]] auto valid() const noexcept -> bool { return static_cast<bool>(handle_); }
+
+    /**
+     * @brief Whether the task has finished, its result is ready.
+     *
+     */
+    [[nodiscard]] auto done() const noexcept -> bool {
+        return handle_.promise().continuation.load(std::memory_order_acquire) ==
+               &internal::task_finished;
+    }
+
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            [[nodiscard]] auto await_ready() const noexcept -> bool {
+                if constexpr (Lazy) {
+                    return false;
+                }
+                else {
+                    return handle.promise().continuation.load(std::memory_order_acquire) ==
+                           &internal::task_finished;
+                }
+            }
+
+            auto await_suspend(const std::coroutine_handle<> awaiting) const noexcept
+                -> std::coroutine_handle<> {
+                auto& continuation = handle.promise().continuation;
+                if constexpr (Lazy) {
+                    continuation.store(awaiting.address(), std::memory_order_relaxed);
+                    return handle;
+                }
+                else {
+                    // an eager task may finish on another thread meanwhile.
+                    void* expected = nullptr;
+                    if (continuation.compare_exchange_strong(
+                            expected, awaiting.address(), std::memory_order_acq_rel,
+                            std::memory_order_acquire)) {
+                        return std::noop_coroutine();
+                    }
+                    return awaiting;
+                }
+            }
+
+            auto await_resume() const -> Ty { return handle.promise().take(); }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+        return awaiter{ handle_ };
+    }
+
+private:
+    explicit basic_task(const std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {}
+
+    void reset() noexcept {
+        if (handle_) {
+            std::exchange(handle_, nullptr).destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * @brief Task starting when it is awaited.
+ *
+ */
+template <typename Ty = void>
+using task = basic_task<Ty, true>;
+
+/**
+ * @brief Task starting as soon as it is called.
+ *
+ */
+template <typename Ty = void>
+using eager_task = basic_task<Ty, false>;
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+struct sync_wait_state {
+    std::mutex mutex;
+    std::condition_variable condvar;
+    bool done{};
+};
+
+/**
+ * @brief Coroutine awaiting a task for `sync_wait`, it signals from its final suspension.
+ *
+ */
+class sync_wait_coroutine {
+public:
+    struct promise_type {
+        auto get_return_object() noexcept -> sync_wait_coroutine {
+            return sync_wait_coroutine{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        [[nodiscard]] constexpr auto initial_suspend() const noexcept -> std::suspend_always {
+            return {};
+        }
+
+        auto final_suspend() const noexcept {
+            struct final_awaiter {
+                [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+                void await_suspend(std::coroutine_handle<promise_type> self) const noexcept {
+                    // the frame is suspended, the waiting thread may destroy it once unlocked.
+                    auto& state = *self.promise().state;
+                    const std::lock_guard lock{ state.mutex };
+                    state.done = true;
+                    state.condvar.notify_one();
+                }
+
+                constexpr void await_resume() const noexcept {}
+            };
+            return final_awaiter{};
+        }
+
+        constexpr void return_void() const noexcept {}
+
+        [[noreturn]] void unhandled_exception() const noexcept { std::terminate(); }
+
+        sync_wait_state* state{};
+    };
+
+    explicit sync_wait_coroutine(const std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {}
+
+    sync_wait_coroutine(const sync_wait_coroutine&)            = delete;
+    sync_wait_coroutine& operator=(const sync_wait_coroutine&) = delete;
+
+    ~sync_wait_coroutine() { handle_.destroy(); }
+
+    void run(sync_wait_state& state) {
+        handle_.promise().state = &state;
+        handle_.resume();
+        std::unique_lock lock{ state.mutex };
+        state.condvar.wait(lock, [&state] { return state.done; });
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename Ty, bool Lazy>
+auto sync_wait_for(basic_task<Ty, Lazy>& task, task_result<Ty>& result) -> sync_wait_coroutine {
+    try {
+        if constexpr (std::is_void_v<Ty>) {
+            co_await std::move(task);
+        }
+        else {
+            result.return_value(co_await std::move(task));
+        }
+    }
+    catch (...) {
+        result.unhandled_exception();
+    }
+}
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Block the calling thread until a task finishes, and return its result.
+ *
+ * This is the boundary between blocking code and tasks, for example in `main`. It must not be
+ * called from a worker of a pool the task runs on.
+ */
+template <typename Ty, bool Lazy>
+auto sync_wait(basic_task<Ty, Lazy> task) -> Ty {
+    internal::task_result<Ty> result;
+    internal::sync_wait_state state;
+    internal::sync_wait_for(task, result).run(state);
+    return result.take();
+}
+
 } // namespace atom::utils
@@ -1,6 +1,9 @@
 #pragma once
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <shared_mutex>
+#include <type_traits>
 
 #if defined(__x86_64__) || defined(__i386__) || defined(_M_IX86) || defined(_M_X64)
     #include <xmmintrin.h>
@@ -21,9 +24,49 @@ inline void cpu_relax() {}
 
 const auto max_spin_time = 1024;
 
+template <typename Mutex>
+concept shared_lockable = requires(Mutex& mutex) {
+    mutex.lock_shared();
+    mutex.unlock_shared();
+};
+
+/**
+ * @brief Lock used for reading, falls back to an exclusive lock if shared locking is unsupported.
+ *
+ */
+template <typename Mutex>
+using shared_guard_t =
+    std::conditional_t<shared_lockable<Mutex>, std::shared_lock<Mutex>, std::lock_guard<Mutex>>;
+
+template <typename Mutex>
+using unique_guard_t = std::lock_guard<Mutex>;
+
 } // namespace internal
 /*! @endcond */
 
+/**
+ * @class null_lock
+ * @brief Lock that does nothing, used to opt out of synchronization.
+ * @details Satisfies both exclusive and shared locking, every operation compiles to nothing.
+ */
+class null_lock {
+public:
+    constexpr null_lock() noexcept         = default;
+    null_lock(const null_lock&)            = delete;
+    null_lock(null_lock&&)                 = delete;
+    null_lock& operator=(const null_lock&) = delete;
+    null_lock& operator=(null_lock&&)      = delete;
+    constexpr ~null_lock() noexcept        = default;
+
+    constexpr auto try_lock() noexcept -> bool { return true; }
+    constexpr void lock() noexcept {}
+    constexpr void unlock() noexcept {}
+
+    constexpr auto try_lock_shared() noexcept -> bool { return true; }
+    constexpr void lock_shared() noexcept {}
+    constexpr void unlock_shared() noexcept {}
+};
+
 #if defined(__cpp_lib_atomic_wait) && __cpp_lib_atomic_wait >= 201907L
 
 /**
@@ -43,8 +86,9 @@ public:
     /**
      * @brief Try get the lock.
      *
+     * @return Whether the lock was acquired.
      */
-    auto try_lock() noexcept -> bool { return flag_.test_and_set(std::memory_order_acquire); }
+    auto try_lock() noexcept -> bool { return !flag_.test_and_set(std::memory_order_acquire); }
 
     void lock() noexcept {
         while (flag_.test_and_set(std::memory_order_acquire)) {
@@ -87,8 +131,9 @@ public:
     /**
      * @brief Try get the lock.
      *
+     * @return Whether the lock was acquired.
      */
-    auto try_lock() noexcept -> bool { return flag_.test_and_set(std::memory_order_acquire); }
+    auto try_lock() noexcept -> bool { return !flag_.test_and_set(std::memory_order_acquire); }
 
     void lock() noexcept {
         while (flag_.test_and_set(std::memory_order_acquire)) {
@@ -124,7 +169,7 @@ public:
     hybrid_spin_lock& operator=(hybrid_spin_lock&&)      = delete;
     ~hybrid_spin_lock()                                  = default;
 
-    auto try_lock() noexcept -> bool { return flag_.test_and_set(std::memory_order_acquire); }
+    auto try_lock() noexcept -> bool { return !flag_.test_and_set(std::memory_order_acquire); }
 
     void lock() noexcept {
         for (auto i = 0;
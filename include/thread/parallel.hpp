@@ -0,0 +1,468 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "core/langdef.hpp"
+#include "thread/task.hpp"
+#include "thread/thread_pool.hpp"
+
+namespace atom::utils {
+
+constexpr std::size_t k_default_parallel_grain = 4096;
+
+/**
+ * @brief How `parallel_for` splits its range between the threads.
+ *
+ */
+enum class partitioning : std::uint8_t {
+    // one contiguous block for each thread, for iterations costing about the same.
+    static_split,
+    // grain-sized chunks claimed one after another, for iterations of uneven cost.
+    dynamic
+};
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Run `func(first, last)` over [0, count) in chunks on the pool and wait for all of them.
+ *
+ * The first chunk ends at `head` and the others are `step` long. The calling thread runs the first
+ * chunk itself. The first exception thrown by any chunk is rethrown once every chunk is done.
+ */
+template <typename Func>
+void run_chunks(
+    thread_pool& pool, const std::size_t count, const std::size_t head, const std::size_t step,
+    Func& func) {
+    const auto first_last = std::min(count, head);
+
+    std::vector<task_future<void>> futures;
+    std::exception_ptr exception;
+    try {
+        for (auto first = first_last; first < count; first += step) {
+            const auto last = std::min(count, first + step);
+            futures.emplace_back(pool.submit([&func, first, last] { func(first, last); }));
+        }
+        func(std::size_t{ 0 }, first_last);
+    }
+    catch (...) {
+        exception = std::current_exception();
+    }
+
+    for (auto& future : futures) {
+        try {
+            future.get();
+        }
+        catch (...) {
+            if (!exception) {
+                exception = std::current_exception();
+            }
+        }
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+/**
+ * @brief Chunking of an array so every chunk but the first starts on a cache line.
+ *
+ * @return End of the first chunk, and the length of the other chunks.
+ */
+template <typename Ty>
+auto cache_aligned_chunks(const Ty* data, const std::size_t grain) noexcept
+    -> std::pair<std::size_t, std::size_t> {
+    constexpr auto line = cache_line_size;
+    // elements from one element starting a cache line to the next one.
+    constexpr auto stride = line / std::gcd(sizeof(Ty), line);
+
+    const auto step    = (std::max<std::size_t>(grain, 1) + stride - 1) / stride * stride;
+    const auto address = reinterpret_cast<std::uintptr_t>(data);
+    for (std::size_t index = 0; index < stride; ++index) {
+        if ((address + index * sizeof(Ty)) % line == 0) {
+            return { index + step, step };
+        }
+    }
+    // the array is not aligned to the size of its elements, no element starts a cache line.
+    return { step, step };
+}
+
+
+/**
+ * @brief Length of the blocks when [0, count) is split once between the pool and the caller.
+ *
+ * There is a block for each worker and one for the calling thread, each at least `grain` long.
+ */
+inline auto static_step(const thread_pool& pool, const std::size_t count, std::size_t grain)
+    -> std::size_t {
+    grain             = std::max<std::size_t>(grain, 1);
+    const auto blocks = std::clamp<std::size_t>(count / grain, 1, pool.size() + 1);
+    return (count + blocks - 1) / blocks;
+}
+
+/**
+ * @brief Run `func(first, last)` over [0, count) with the given partitioning and wait for it.
+ *
+ * With `partitioning::dynamic` the calling thread and as many workers as useful claim
+ * `grain`-sized chunks from a shared counter until none is left. After an exception no new chunk
+ * is claimed.
+ */
+template <typename Func>
+void run_partitioned(
+    thread_pool& pool, const std::size_t count, std::size_t grain, const partitioning mode,
+    Func& func) {
+    if (count == 0) {
+        return;
+    }
+    if (mode == partitioning::static_split) {
+        const auto step = static_step(pool, count, grain);
+        run_chunks(pool, count, step, step, func);
+        return;
+    }
+
+    grain              = std::max<std::size_t>(grain, 1);
+    const auto helpers = std::min<std::size_t>(pool.size(), (count - 1) / grain);
+    std::atomic<std::size_t> next{};
+    auto drain = [&](std::size_t, std::size_t) {
+        for (auto first = next.fetch_add(grain, std::memory_order_relaxed); first < count;
+             first      = next.fetch_add(grain, std::memory_order_relaxed)) {
+            try {
+                func(first, std::min(count, first + grain));
+            }
+            catch (...) {
+                next.store(count, std::memory_order_relaxed);
+                throw;
+            }
+        }
+    };
+    run_chunks(pool, helpers + 1, 1, 1, drain);
+}
+
+/**
+ * @brief Number of elements `a` gives to the first `rank` elements of the merge of `a` and `b`.
+ *
+ * Equal elements are taken from `a` first, as `std::merge` does.
+ */
+template <typename Iter, typename Comp>
+auto merge_split(
+    Iter a, const std::size_t size_a, Iter b, const std::size_t size_b, const std::size_t rank,
+    Comp& comp) -> std::size_t {
+    auto low  = rank > size_b ? rank - size_b : 0;
+    auto high = std::min(rank, size_a);
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (!comp(b[rank - mid - 1], a[mid])) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Merge each pair of sorted runs `width` long from `source` into `target`.
+ *
+ * The output is cut in blocks of `step` elements regardless of the runs, so the last rounds, with
+ * only a couple of long runs, keep every thread busy. Cut points are searched before anything is
+ * moved.
+ */
+template <typename Source, typename Target, typename Comp>
+void merge_runs(
+    thread_pool& pool, Source source, Target target, const std::size_t count,
+    const std::size_t width, const std::size_t step, Comp& comp) {
+    const auto pair_of = [count, width](const std::size_t position) {
+        const auto first  = position / (width * 2) * (width * 2);
+        const auto size_a = std::min(width, count - first);
+        const auto size_b = std::min(width, count - first - size_a);
+        return std::tuple{ first, size_a, size_b };
+    };
+
+    std::vector<std::size_t> splits;
+    for (std::size_t position = 0;; position = std::min(count, position + step)) {
+        const auto [first, size_a, size_b] = pair_of(position);
+        splits.emplace_back(merge_split(
+            source + first, size_a, source + first + size_a, size_b, position - first, comp));
+        if (position == count) {
+            break;
+        }
+    }
+
+    auto chunk = [&](const std::size_t chunk_first, const std::size_t chunk_last) {
+        const auto index = chunk_first / step;
+        for (auto position = chunk_first; position != chunk_last;) {
+            const auto [first, size_a, size_b] = pair_of(position);
+            const auto last                    = first + size_a + size_b;
+            const auto end                     = std::min(chunk_last, last);
+            const auto from_a = position == first ? 0 : splits[index];
+            const auto to_a   = end == last ? size_a : splits[index + 1];
+            const auto a      = source + first;
+            const auto b      = a + size_a;
+            std::ranges::merge(
+                std::make_move_iterator(a + from_a), std::make_move_iterator(a + to_a),
+                std::make_move_iterator(b + (position - first - from_a)),
+                std::make_move_iterator(b + (end - first - to_a)), target + position, comp);
+            position = end;
+        }
+    };
+    run_chunks(pool, count, step, step, chunk);
+}
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Apply `func` to every element of a contiguous range, in chunks run on the pool.
+ *
+ * Chunks start on cache lines whenever the layout of the array allows it, so threads never write
+ * to the same line. The range, for example a `dense_map` or a `dense_set`, is not locked and
+ * should not be modified until this returns.
+ * @param grain Minimum number of elements in each chunk, rounded up to whole cache lines.
+ */
+template <std::ranges::contiguous_range Rng, typename Func>
+requires std::ranges::sized_range<Rng> &&
+         std::invocable<Func&, std::ranges::range_reference_t<Rng>>
+void parallel_for_each(
+    Rng&& range, Func func, thread_pool& pool,
+    const std::size_t grain = k_default_parallel_grain) {
+    const auto count = static_cast<std::size_t>(std::ranges::size(range));
+    if (count == 0) {
+        return;
+    }
+
+    auto* const data        = std::to_address(std::ranges::begin(range));
+    const auto [head, step] = internal::cache_aligned_chunks(data, grain);
+
+    auto chunk = [data, &func](const std::size_t first, const std::size_t last) {
+        for (auto index = first; index != last; ++index) {
+            func(data[index]);
+        }
+    };
+    internal::run_chunks(pool, count, head, step, chunk);
+}
+
+/**
+ * @brief Call `func(index)` for every index in [first, last), in chunks run on the pool.
+ *
+ * @param grain Minimum number of indices in each chunk, or the length of every chunk with
+ * `partitioning::dynamic`.
+ * @param mode How the indices are split between the threads.
+ */
+template <std::integral Int, typename Func>
+requires std::invocable<Func&, Int>
+void parallel_for(
+    const Int first, const Int last, Func func, thread_pool& pool,
+    const std::size_t grain = k_default_parallel_grain,
+    const partitioning mode = partitioning::static_split) {
+    const auto count = first < last ? static_cast<std::size_t>(last - first) : std::size_t{};
+
+    auto chunk = [first, &func](const std::size_t chunk_first, const std::size_t chunk_last) {
+        for (auto index = chunk_first; index != chunk_last; ++index) {
+            func(static_cast<Int>(first + static_cast<Int>(index)));
+        }
+    };
+    internal::run_partitioned(pool, count, grain, mode, chunk);
+}
+
+/**
+ * @brief Apply `func` to every element of a random-access range, in chunks run on the pool.
+ *
+ * Unlike `parallel_for_each`, the range does not need to be contiguous and the chunks may be
+ * claimed dynamically.
+ * @param grain Minimum number of elements in each chunk, or the length of every chunk with
+ * `partitioning::dynamic`.
+ * @param mode How the elements are split between the threads.
+ */
+template <std::ranges::random_access_range Rng, typename Func>
+requires std::ranges::sized_range<Rng> &&
+         std::invocable<Func&, std::ranges::range_reference_t<Rng>>
+void parallel_for(
+    Rng&& range, Func func, thread_pool& pool, const std::size_t grain = k_default_parallel_grain,
+    const partitioning mode = partitioning::static_split) {
+    const auto count = static_cast<std::size_t>(std::ranges::size(range));
+    const auto begin = std::ranges::begin(range);
+
+    auto chunk = [begin, &func](const std::size_t first, const std::size_t last) {
+        for (auto iter = begin + first; iter != begin + last; ++iter) {
+            func(*iter);
+        }
+    };
+    internal::run_partitioned(pool, count, grain, mode, chunk);
+}
+
+/**
+ * @brief Reduce a random-access range with `op`, one block for each thread.
+ *
+ * Each block is folded from its first element and the partial results are then folded into
+ * `init` in order, so `op` must be associative but need not be commutative.
+ * @param grain Minimum number of elements in each block.
+ */
+template <std::ranges::random_access_range Rng, typename Ty, typename BinaryOp>
+requires std::ranges::sized_range<Rng> &&
+         std::constructible_from<Ty, std::ranges::range_reference_t<Rng>> &&
+         std::convertible_to<
+             std::invoke_result_t<BinaryOp&, Ty, std::ranges::range_reference_t<Rng>>, Ty> &&
+         std::convertible_to<std::invoke_result_t<BinaryOp&, Ty, Ty>, Ty>
+auto parallel_reduce(
+    Rng&& range, Ty init, BinaryOp op, thread_pool& pool,
+    const std::size_t grain = k_default_parallel_grain) -> Ty {
+    const auto count = static_cast<std::size_t>(std::ranges::size(range));
+    if (count == 0) {
+        return init;
+    }
+
+    const auto begin = std::ranges::begin(range);
+    const auto step  = internal::static_step(pool, count, grain);
+    std::vector<std::optional<Ty>> partials((count + step - 1) / step);
+
+    auto block = [&](const std::size_t first, const std::size_t last) {
+        Ty value(begin[first]);
+        for (auto index = first + 1; index != last; ++index) {
+            value = op(std::move(value), begin[index]);
+        }
+        partials[first / step].emplace(std::move(value));
+    };
+    internal::run_chunks(pool, count, step, step, block);
+
+    for (auto& partial : partials) {
+        init = op(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+/**
+ * @brief Write the inclusive scan of a random-access range with `op` to `out`.
+ *
+ * The range is reduced block by block, the totals of the blocks are scanned on the calling thread
+ * and each block is then scanned from the total of the blocks before it. The input is read twice
+ * and `op` must be associative. `out` may be the beginning of the range itself.
+ * @param grain Minimum number of elements in each block.
+ * @return Iterator past the last element written.
+ */
+template <std::ranges::random_access_range Rng, std::random_access_iterator Out, typename BinaryOp>
+requires std::ranges::sized_range<Rng> &&
+         std::indirectly_writable<Out, std::ranges::range_value_t<Rng>> &&
+         std::convertible_to<
+             std::invoke_result_t<
+                 BinaryOp&, std::ranges::range_value_t<Rng>, std::ranges::range_reference_t<Rng>>,
+             std::ranges::range_value_t<Rng>> &&
+         std::convertible_to<
+             std::invoke_result_t<
+                 BinaryOp&, std::ranges::range_value_t<Rng>, std::ranges::range_value_t<Rng>&>,
+             std::ranges::range_value_t<Rng>>
+auto parallel_inclusive_scan(
+    Rng&& range, Out out, BinaryOp op, thread_pool& pool,
+    const std::size_t grain = k_default_parallel_grain) -> Out {
+    using value_type = std::ranges::range_value_t<Rng>;
+
+    const auto count = static_cast<std::size_t>(std::ranges::size(range));
+    if (count == 0) {
+        return out;
+    }
+
+    const auto begin  = std::ranges::begin(range);
+    const auto step   = internal::static_step(pool, count, grain);
+    const auto blocks = (count + step - 1) / step;
+
+    // totals of every block but the last, then what precedes each block.
+    std::vector<std::optional<value_type>> carries(blocks);
+    if (blocks > 1) {
+        auto reduce = [&](const std::size_t first, const std::size_t last) {
+            value_type value(begin[first]);
+            for (auto index = first + 1; index != last; ++index) {
+                value = op(std::move(value), begin[index]);
+            }
+            carries[first / step + 1].emplace(std::move(value));
+        };
+        internal::run_chunks(pool, (blocks - 1) * step, step, step, reduce);
+        for (std::size_t index = 2; index < blocks; ++index) {
+            carries[index].emplace(op(*carries[index - 1], std::move(*carries[index])));
+        }
+    }
+
+    auto scan = [&](const std::size_t first, const std::size_t last) {
+        auto& carry = carries[first / step];
+        value_type value(
+            carry ? value_type(op(std::move(*carry), begin[first])) : value_type(begin[first]));
+        out[first] = value;
+        for (auto index = first + 1; index != last; ++index) {
+            value      = op(std::move(value), begin[index]);
+            out[index] = value;
+        }
+    };
+    internal::run_chunks(pool, count, step, step, scan);
+    return out + count;
+}
+
+/**
+ * @brief Sort a random-access range with a parallel merge sort.
+ *
+ * A block for each thread is sorted with `std::ranges::sort`, then runs are merged pairwise
+ * between the range and a buffer as large as the range, every round being split evenly between the
+ * threads. Like `std::sort`, the sort is not stable.
+ * @param grain Minimum number of elements in each block.
+ */
+template <std::ranges::random_access_range Rng, typename Comp>
+requires std::ranges::sized_range<Rng> && std::sortable<std::ranges::iterator_t<Rng>, Comp> &&
+         std::default_initializable<std::ranges::range_value_t<Rng>>
+void parallel_sort(
+    Rng&& range, Comp comp, thread_pool& pool,
+    const std::size_t grain = k_default_parallel_grain) {
+    const auto count = static_cast<std::size_t>(std::ranges::size(range));
+    const auto begin = std::ranges::begin(range);
+    const auto step  = internal::static_step(pool, count, grain);
+    if (step >= count) {
+        std::ranges::sort(begin, begin + count, comp);
+        return;
+    }
+
+    auto sort = [&](const std::size_t first, const std::size_t last) {
+        std::ranges::sort(begin + first, begin + last, comp);
+    };
+    internal::run_chunks(pool, count, step, step, sort);
+
+    std::vector<std::ranges::range_value_t<Rng>> buffer(count);
+    bool in_buffer = false;
+    for (auto width = step; width < count; width *= 2, in_buffer = !in_buffer) {
+        if (in_buffer) {
+            internal::merge_runs(pool, buffer.begin(), begin, count, width, step, comp);
+        }
+        else {
+            internal::merge_runs(pool, begin, buffer.begin(), count, width, step, comp);
+        }
+    }
+
+    if (in_buffer) {
+        auto move_back = [&](const std::size_t first, const std::size_t last) {
+            std::ranges::move(buffer.begin() + first, buffer.begin() + last, begin + first);
+        };
+        internal::run_chunks(pool, count, step, step, move_back);
+    }
+}
+
+/**
+ * @brief Sort a random-access range in ascending order with a parallel merge sort.
+ *
+ */
+template <std::ranges::random_access_range Rng>
+requires std::ranges::sized_range<Rng> && std::sortable<std::ranges::iterator_t<Rng>> &&
+         std::default_initializable<std::ranges::range_value_t<Rng>>
+void parallel_sort(
+    Rng&& range, thread_pool& pool, const std::size_t grain = k_default_parallel_grain) {
+    parallel_sort(std::forward<Rng>(range), std::ranges::less{}, pool, grain);
+}
+
+} // namespace atom::utils
@@ -0,0 +1,368 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "memory/pool.hpp"
+#include "thread/lock.hpp"
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Operations on the callable held by a `unique_task`.
+ *
+ */
+struct task_vtable {
+    void (*invoke)(void*);
+    // move the callable into uninitialized storage and destroy the source.
+    void (*relocate)(void* target, void* source) noexcept;
+    void (*destroy)(void*) noexcept;
+};
+
+template <typename Func, bool Inline>
+constexpr task_vtable task_vtable_for{
+    [](void* buffer) { (*static_cast<Func*>(buffer))(); },
+    [](void* target, void* source) noexcept {
+        std::construct_at(static_cast<Func*>(target), std::move(*static_cast<Func*>(source)));
+        std::destroy_at(static_cast<Func*>(source));
+    },
+    [](void* buffer) noexcept { std::destroy_at(static_cast<Func*>(buffer)); }
+};
+
+template <typename Func>
+constexpr task_vtable task_vtable_for<Func, false>{
+    [](void* buffer) { (**static_cast<Func**>(buffer))(); },
+    [](void* target, void* source) noexcept {
+        *static_cast<Func**>(target) = *static_cast<Func**>(source);
+    },
+    [](void* buffer) noexcept { delete *static_cast<Func**>(buffer); }
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Move-only `void()` callable, keeping small callables inside itself.
+ *
+ * A callable up to `buffer_size` bytes, aligned to a pointer at most and nothrow movable, is stored
+ * inline and costs no allocation. Larger ones are moved to the heap. The whole task is one cache
+ * line.
+ */
+class unique_task {
+public:
+    constexpr static std::size_t buffer_size = 64 - sizeof(void*);
+
+    template <typename Func>
+    constexpr static bool fits_inline = sizeof(Func) <= buffer_size &&
+                                        alignof(Func) <= alignof(void*) &&
+                                        std::is_nothrow_move_constructible_v<Func>;
+
+    unique_task() noexcept = default;
+
+    template <typename Func>
+    requires(!std::is_same_v<std::remove_cvref_t<Func>, unique_task>) &&
+            std::is_invocable_v<std::decay_t<Func>&>
+    unique_task(Func&& func) { // NOLINT(google-explicit-constructor)
+        using func_type = std::decay_t<Func>;
+        if constexpr (fits_inline<func_type>) {
+            std::construct_at(reinterpret_cast<func_type*>(buffer_), std::forward<Func>(func));
+            vtable_ = &internal::task_vtable_for<func_type, true>;
+        }
+        else {
+            *reinterpret_cast<func_type**>(buffer_) = new func_type(std::forward<Func>(func));
+            vtable_ = &internal::task_vtable_for<func_type, false>;
+        }
+    }
+
+    unique_task(const unique_task&)            = delete;
+    unique_task& operator=(const unique_task&) = delete;
+
+    unique_task(unique_task&& that) noexcept : vtable_(that.vtable_) {
+        if (vtable_ != nullptr) {
+            vtable_->relocate(buffer_, that.buffer_);
+            that.vtable_ = nullptr;
+        }
+    }
+
+    unique_task& operator=(unique_task&& that) noexcept {
+        if (this != &that) {
+            reset();
+            if (that.vtable_ != nullptr) {
+                that.vtable_->relocate(buffer_, that.buffer_);
+                vtable_      = std::exchange(that.vtable_, nullptr);
+            }
+        }
+        return *this;
+    }
+
+    ~unique_task() { reset(); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    void operator()() { vtable_->invoke(buffer_); }
+
+    void reset() noexcept {
+        if (vtable_ != nullptr) {
+            std::exchange(vtable_, nullptr)->destroy(buffer_);
+        }
+    }
+
+private:
+    const internal::task_vtable* vtable_{};
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    alignas(void*) std::byte buffer_[buffer_size];
+};
+
+template <typename Ty>
+class task_future;
+
+template <typename Ty>
+class task_promise;
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Pool shared by the states of every `task_promise`.
+ *
+ * It is never destroyed, as a future may outlive any static object.
+ */
+inline auto task_state_pool() -> synchronized_pool& {
+    static auto* const pool = new synchronized_pool; // NOLINT(cppcoreguidelines-owning-memory)
+    return *pool;
+}
+
+template <typename Ty>
+struct task_value {
+    template <typename... Args>
+    void set(Args&&... args) {
+        value.emplace(std::forward<Args>(args)...);
+    }
+
+    auto take() -> Ty { return std::move(*value); }
+
+    std::optional<Ty> value;
+};
+
+template <>
+struct task_value<void> {
+    void set() noexcept {}
+    void take() noexcept {}
+};
+
+/**
+ * @brief State shared by a `task_promise` and its `task_future`, allocated from a pool.
+ *
+ */
+template <typename Ty>
+class task_state {
+public:
+    static auto create() -> task_state* {
+        return std::construct_at(task_state_pool().allocate<task_state>(1, alignment()));
+    }
+
+    void retain() noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::destroy_at(this);
+            task_state_pool().deallocate(this, 1, alignment());
+        }
+    }
+
+    template <typename... Args>
+    void set_value(Args&&... args) {
+        value_.set(std::forward<Args>(args)...);
+        publish();
+    }
+
+    void set_exception(std::exception_ptr exception) noexcept {
+        exception_ = std::move(exception);
+        publish();
+    }
+
+    [[nodiscard]] auto ready() const noexcept -> bool {
+        return ready_.load(std::memory_order_acquire) != 0;
+    }
+
+    void wait() const noexcept {
+        for (auto i = 0; i < max_spin_time && !ready(); ++i) {
+            cpu_relax();
+        }
+        while (!ready()) {
+            ready_.wait(0, std::memory_order_acquire);
+        }
+    }
+
+    auto get() -> Ty {
+        wait();
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+        return value_.take();
+    }
+
+private:
+    constexpr static auto alignment() noexcept -> std::align_val_t {
+        return std::align_val_t{ std::max<std::size_t>(alignof(task_state), 16) };
+    }
+
+    void publish() noexcept {
+        ready_.store(1, std::memory_order_release);
+        ready_.notify_all();
+    }
+
+    std::atomic<std::uint32_t> ready_{};
+    std::atomic<std::uint32_t> refs_{ 1 };
+    task_value<Ty> value_;
+    std::exception_ptr exception_;
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief One-shot promise whose state comes from a pool shared by all threads.
+ *
+ * It works like `std::promise`, but creating the pair costs no call to `operator new` once the pool
+ * is warm, and a ready result is seen by the waiting thread without a lock.
+ */
+template <typename Ty>
+class task_promise {
+public:
+    task_promise() : state_(internal::task_state<Ty>::create()) {}
+
+    task_promise(const task_promise&)            = delete;
+    task_promise& operator=(const task_promise&) = delete;
+
+    task_promise(task_promise&& that) noexcept
+        : state_(std::exchange(that.state_, nullptr)), satisfied_(that.satisfied_) {}
+
+    task_promise& operator=(task_promise&& that) noexcept {
+        if (this != &that) {
+            abandon();
+            state_     = std::exchange(that.state_, nullptr);
+            satisfied_ = that.satisfied_;
+        }
+        return *this;
+    }
+
+    ~task_promise() { abandon(); }
+
+    /**
+     * @brief Get the future, at most once.
+     *
+     */
+    [[nodiscard]] auto get_future() -> task_future<Ty> {
+        state_->retain();
+        return task_future<Ty>{ state_ };
+    }
+
+    template <typename... Args>
+    void set_value(Args&&... args) {
+        state_->set_value(std::forward<Args>(args)...);
+        satisfied_ = true;
+    }
+
+    void set_exception(std::exception_ptr exception) noexcept {
+        state_->set_exception(std::move(exception));
+        satisfied_ = true;
+    }
+
+private:
+    /**
+     * @brief Drop the state, breaking the promise if no result was set.
+     *
+     */
+    void abandon() noexcept {
+        if (state_ == nullptr) {
+            return;
+        }
+        if (!satisfied_) {
+            state_->set_exception(
+                std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+        std::exchange(state_, nullptr)->release();
+    }
+
+    internal::task_state<Ty>* state_;
+    bool satisfied_{};
+};
+
+/**
+ * @brief Future of a `task_promise`.
+ *
+ */
+template <typename Ty>
+class task_future {
+    friend class task_promise<Ty>;
+
+    explicit task_future(internal::task_state<Ty>* state) noexcept : state_(state) {}
+
+public:
+    task_future() noexcept = default;
+
+    task_future(const task_future&)            = delete;
+    task_future& operator=(const task_future&) = delete;
+
+    task_future(task_future&& that) noexcept : state_(std::exchange(that.state_, nullptr)) {}
+
+    task_future& operator=(task_future&& that) noexcept {
+        if (this != &that) {
+            reset();
+            state_ = std::exchange(that.state_, nullptr);
+        }
+        return *this;
+    }
+
+    ~task_future() { reset(); }
+
+    [[nodiscard]] auto valid() const noexcept -> bool { return state_ != nullptr; }
+
+    /**
+     * @brief Whether the result is set, `get` would not block.
+     *
+     */
+    [[nodiscard]] auto ready() const noexcept -> bool { return state_->ready(); }
+
+    /**
+     * @brief Block until the result is set, spinning briefly before sleeping.
+     *
+     */
+    void wait() const noexcept { state_->wait(); }
+
+    /**
+     * @brief Wait for the result and take it, the future is no longer valid afterwards.
+     *
+     */
+    auto get() -> Ty {
+        const std::unique_ptr<internal::task_state<Ty>, releaser> state{ std::exchange(
+            state_, nullptr) };
+        return state->get();
+    }
+
+private:
+    struct releaser {
+        void operator()(internal::task_state<Ty>* state) const noexcept { state->release(); }
+    };
+
+    void reset() noexcept {
+        if (state_ != nullptr) {
+            std::exchange(state_, nullptr)->release();
+        }
+    }
+
+    internal::task_state<Ty>* state_{};
+};
+
+} // namespace atom::utils
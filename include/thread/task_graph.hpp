@@ -0,0 +1,310 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "thread/task.hpp"
+#include "thread/thread_pool.hpp"
+
+namespace atom::utils {
+
+/**
+ * @brief Timings of the last run of a `task_graph`.
+ *
+ * Times are measured from the start of the run. The critical path is the chain of dependent nodes
+ * with the largest total duration, no number of threads can finish the graph faster.
+ */
+struct task_graph_timings {
+    using size_type = std::size_t;
+
+    struct node_timing {
+        std::string_view name;
+        std::chrono::nanoseconds start;
+        std::chrono::nanoseconds duration;
+    };
+
+    /// @brief A timing for every node, in the order they were added.
+    std::vector<node_timing> nodes;
+    /// @brief Nodes of the critical path, first to last.
+    std::vector<size_type> critical_path;
+    /// @brief Sum of the durations of the nodes on the critical path.
+    std::chrono::nanoseconds critical_path_length;
+    /// @brief Time from the start of the run to the end of the last node.
+    std::chrono::nanoseconds elapsed;
+
+    /**
+     * @brief Readable report, one line for each node on the critical path.
+     *
+     */
+    [[nodiscard]] auto to_string() const -> std::string {
+        const auto micros = [](const std::chrono::nanoseconds time) {
+            return std::to_string(time.count() / 1000) + '.' +
+                   std::to_string(time.count() % 1000 / 100) + "us";
+        };
+
+        std::string out = "critical path " + micros(critical_path_length) + " of " +
+                          micros(elapsed) + " elapsed\n";
+        for (const auto index : critical_path) {
+            const auto& node = nodes[index];
+            out += "  [" + std::to_string(index) + "] ";
+            out += node.name;
+            out += " at " + micros(node.start) + " took " + micros(node.duration) + '\n';
+        }
+        return out;
+    }
+};
+
+/**
+ * @brief Graph of tasks with dependencies, run on a `thread_pool` as often as needed.
+ *
+ * Each node holds its successors and counts its unfinished predecessors. A node is scheduled only
+ * once the last of them finishes, so no worker ever blocks on a dependency. The thread finishing a
+ * node runs the first successor it made ready itself and submits the others. Running the graph
+ * again reuses every node, nothing is allocated once the pool is warm.
+ *
+ * Nodes and edges may not be added while the graph runs, and `run` should not be called from a
+ * worker of the pool it runs on, as it blocks.
+ */
+class task_graph {
+    struct node {
+        template <typename Func>
+        node(const std::size_t index, std::string&& name, Func&& func)
+            : index(index), name(std::move(name)), work(std::forward<Func>(func)) {}
+
+        std::size_t index;
+        std::string name;
+        unique_task work;
+        std::vector<node*> successors;
+        std::uint32_t predecessors{};
+        std::atomic<std::uint32_t> pending{};
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point finish;
+    };
+
+public:
+    using size_type = std::size_t;
+
+    task_graph() = default;
+
+    task_graph(const task_graph&)            = delete;
+    task_graph(task_graph&&)                 = delete;
+    task_graph& operator=(const task_graph&) = delete;
+    task_graph& operator=(task_graph&&)      = delete;
+    ~task_graph()                            = default;
+
+    /**
+     * @brief Add a node running `func`, called once on every run.
+     *
+     * @return Index of the node.
+     */
+    template <typename Func>
+    requires std::is_invocable_v<std::decay_t<Func>&>
+    auto emplace(Func&& func) -> size_type {
+        return emplace(std::string{}, std::forward<Func>(func));
+    }
+
+    /**
+     * @brief Add a named node running `func`, the name shows up in the timings.
+     *
+     * @return Index of the node.
+     */
+    template <typename Func>
+    requires std::is_invocable_v<std::decay_t<Func>&>
+    auto emplace(std::string name, Func&& func) -> size_type {
+        nodes_.emplace_back(nodes_.size(), std::move(name), std::forward<Func>(func));
+        sorted_ = false;
+        return nodes_.size() - 1;
+    }
+
+    /**
+     * @brief Make `after` wait for `before` to finish.
+     *
+     */
+    void precede(const size_type before, const size_type after) {
+        auto& target = nodes_.at(after);
+        nodes_.at(before).successors.emplace_back(&target);
+        ++target.predecessors;
+        sorted_ = false;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_type { return nodes_.size(); }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return nodes_.empty(); }
+
+    /**
+     * @brief Run every node on the pool and wait until all are done.
+     *
+     * If a node throws, nodes not started yet are skipped and the first exception is rethrown.
+     * @throw std::logic_error The graph has a cycle, checked once after each change.
+     */
+    void run(thread_pool& pool) {
+        if (!sorted_) {
+            sort();
+        }
+        if (nodes_.empty()) {
+            return;
+        }
+
+        pool_ = &pool;
+        remaining_.store(static_cast<std::uint32_t>(nodes_.size()), std::memory_order_relaxed);
+        failed_.store(false, std::memory_order_relaxed);
+        exception_ = nullptr;
+        finished_  = false;
+        for (auto& entry : nodes_) {
+            entry.pending.store(entry.predecessors, std::memory_order_relaxed);
+        }
+
+        start_ = std::chrono::steady_clock::now();
+        for (auto* const root : roots_) {
+            pool.submit_detached([this, root] { execute(root); });
+        }
+
+        {
+            std::unique_lock lock{ mutex_ };
+            condvar_.wait(lock, [this] { return finished_; });
+        }
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    /**
+     * @brief Timings of the last run, and its critical path.
+     *
+     */
+    [[nodiscard]] auto timings() const -> task_graph_timings {
+        task_graph_timings timings{};
+        if (!sorted_ || nodes_.empty()) {
+            return timings;
+        }
+
+        // longest chain ending at each node, found in topological order.
+        std::vector<std::chrono::nanoseconds> longest(nodes_.size());
+        std::vector<size_type> previous(nodes_.size(), nodes_.size());
+        auto last = order_.front();
+        for (const auto index : order_) {
+            const auto& entry = nodes_[index];
+            longest[index] += entry.finish - entry.start;
+            for (auto* const successor : entry.successors) {
+                const auto next = successor->index;
+                if (longest[index] > longest[next]) {
+                    longest[next]  = longest[index];
+                    previous[next] = index;
+                }
+            }
+            if (longest[index] > longest[last]) {
+                last = index;
+            }
+        }
+
+        for (auto index = last; index != nodes_.size(); index = previous[index]) {
+            timings.critical_path.emplace_back(index);
+        }
+        std::ranges::reverse(timings.critical_path);
+        timings.critical_path_length = longest[last];
+
+        auto finish = start_;
+        for (const auto& entry : nodes_) {
+            timings.nodes.emplace_back(
+                entry.name, entry.start - start_, entry.finish - entry.start);
+            finish = std::max(finish, entry.finish);
+        }
+        timings.elapsed = finish - start_;
+        return timings;
+    }
+
+private:
+    /**
+     * @brief Find the roots and a topological order, or throw if there is a cycle.
+     *
+     */
+    void sort() {
+        std::vector<std::uint32_t> pending(nodes_.size());
+        roots_.clear();
+        order_.clear();
+        for (size_type index = 0; index < nodes_.size(); ++index) {
+            pending[index] = nodes_[index].predecessors;
+            if (pending[index] == 0) {
+                roots_.emplace_back(&nodes_[index]);
+                order_.emplace_back(index);
+            }
+        }
+        for (size_type cursor = 0; cursor < order_.size(); ++cursor) {
+            for (auto* const successor : nodes_[order_[cursor]].successors) {
+                const auto next = successor->index;
+                if (--pending[next] == 0) {
+                    order_.emplace_back(next);
+                }
+            }
+        }
+        if (order_.size() != nodes_.size()) {
+            throw std::logic_error("task graph has a cycle");
+        }
+        sorted_ = true;
+    }
+
+    void execute(node* current) {
+        while (current != nullptr) {
+            current->start = std::chrono::steady_clock::now();
+            if (!failed_.load(std::memory_order_relaxed)) {
+                try {
+                    current->work();
+                }
+                catch (...) {
+                    if (!failed_.exchange(true, std::memory_order_relaxed)) {
+                        exception_ = std::current_exception();
+                    }
+                }
+            }
+            current->finish = std::chrono::steady_clock::now();
+
+            // the first successor made ready is a continuation on this thread.
+            node* next = nullptr;
+            for (auto* const successor : current->successors) {
+                if (successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (next == nullptr) {
+                        next = successor;
+                    }
+                    else {
+                        pool_->submit_detached([this, successor] { execute(successor); });
+                    }
+                }
+            }
+
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                // the graph may be destroyed as soon as the lock is released.
+                const std::lock_guard lock{ mutex_ };
+                finished_ = true;
+                condvar_.notify_one();
+            }
+            current = next;
+        }
+    }
+
+    std::deque<node> nodes_;
+    std::vector<node*> roots_;
+    std::vector<size_type> order_;
+    bool sorted_{ true };
+
+    thread_pool* pool_{};
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<std::uint32_t> remaining_;
+    std::atomic<bool> failed_;
+    std::exception_ptr exception_;
+    std::mutex mutex_;
+    std::condition_variable condvar_;
+    bool finished_{};
+};
+
+} // namespace atom::utils
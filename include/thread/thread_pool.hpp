@@ -1,21 +1,196 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <future>
+#include <limits>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <span>
 #include <stdexcept>
 #include <thread>
 #include <type_traits>
+#include <vector>
+#include "memory/pool.hpp"
+#include "thread/lock.hpp"
+#include "thread/task.hpp"
+#include "thread/work_stealing_deque.hpp"
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
 
 namespace atom::utils {
 
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Circular queue that doubles when full, so it stops allocating once it is large enough.
+ *
+ */
+template <typename Ty>
+class ring_queue {
+public:
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+    void push(Ty value) {
+        if (size_ == slots_.size()) {
+            grow();
+        }
+        slots_[(head_ + size_) & (slots_.size() - 1)] = std::move(value);
+        ++size_;
+    }
+
+    auto pop() -> Ty {
+        auto value = std::move(slots_[head_]);
+        head_      = (head_ + 1) & (slots_.size() - 1);
+        --size_;
+        return value;
+    }
+
+private:
+    void grow() {
+        std::vector<Ty> slots(std::max<std::size_t>(slots_.size() * 2, 64));
+        for (std::size_t i = 0; i < size_; ++i) {
+            slots[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+        }
+        slots_ = std::move(slots);
+        head_  = 0;
+    }
+
+    std::vector<Ty> slots_;
+    std::size_t head_{};
+    std::size_t size_{};
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief How a `thread_pool` hands tasks to its workers.
+ *
+ */
+enum class scheduling : std::uint8_t {
+    // one queue guarded by a mutex, shared by every worker.
+    shared_queue,
+    // a deque for each worker, idle workers steal from the others.
+    work_stealing
+};
+
+/**
+ * @brief Lane of a task in a `thread_pool`, higher lanes are served first.
+ *
+ */
+enum class task_priority : std::uint8_t {
+    high,
+    normal,
+    low
+};
+
+/**
+ * @brief Hints given to a `thread_pool` with a task.
+ *
+ */
+struct task_hint {
+    constexpr static std::uint32_t any_worker = std::numeric_limits<std::uint32_t>::max();
+
+    task_priority priority{ task_priority::normal };
+    /**
+     * @brief Index of the worker to run the task on, modulo the number of workers.
+     *
+     * Such a task bypasses the lanes and runs on that worker, before anything else it would take.
+     */
+    std::uint32_t worker{ any_worker };
+};
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief A `ring_queue` for each priority, served highest first.
+ *
+ * A lane passed over `k_starvation_limit` times in a row while holding tasks is served next, so
+ * low-priority tasks keep moving under a flood of urgent ones.
+ */
+template <typename Ty>
+class priority_lanes {
+public:
+    constexpr static std::uint32_t k_starvation_limit = 16;
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+    [[nodiscard]] auto size(const task_priority priority) const noexcept -> std::size_t {
+        return sizes_[static_cast<std::size_t>(priority)];
+    }
+
+    void push(Ty value, const task_priority priority) {
+        const auto lane = static_cast<std::size_t>(priority);
+        lanes_[lane].push(std::move(value));
+        ++sizes_[lane];
+        ++size_;
+    }
+
+    auto pop() -> Ty {
+        auto lane = lanes_.size();
+        for (auto index = lanes_.size() - 1; index != 0; --index) {
+            if (sizes_[index] != 0 && passed_[index] >= k_starvation_limit) {
+                lane = index;
+                break;
+            }
+        }
+        if (lane == lanes_.size()) {
+            lane = 0;
+            while (sizes_[lane] == 0) {
+                ++lane;
+            }
+        }
+
+        for (auto index = lane + 1; index < lanes_.size(); ++index) {
+            passed_[index] += sizes_[index] != 0 ? 1 : 0;
+        }
+        passed_[lane] = 0;
+        --sizes_[lane];
+        --size_;
+        return lanes_[lane].pop();
+    }
+
+private:
+    constexpr static std::size_t k_lanes = 3;
+
+    std::array<ring_queue<Ty>, k_lanes> lanes_;
+    std::array<std::size_t, k_lanes> sizes_{};
+    std::array<std::uint32_t, k_lanes> passed_{};
+    std::size_t size_{};
+};
+
+} // namespace internal
+/*! @endcond */
+
 class thread_pool final {
+    struct worker {
+        worker(thread_pool* pool, const std::uint64_t seed) : pool(pool), seed(seed) {}
+
+        thread_pool* pool;
+        work_stealing_deque<unique_task> deque;
+        std::uint64_t seed;
+        // tasks hinted to this worker, nobody else takes them.
+        std::mutex inbox_mutex;
+        internal::ring_queue<unique_task*> inbox;
+        std::atomic<std::size_t> inbox_count;
+    };
+
+    constexpr static auto k_spin_rounds = 64;
+
 public:
     thread_pool(const std::size_t num_threads = std::thread::hardware_concurrency())
-        : num_threads_(num_threads) {
+        : num_threads_(num_threads), inboxes_(num_threads) {
         try {
-            for (auto i = 0; i < num_threads / 2; ++i) {
+            for (std::size_t i = 0; i < num_threads / 2; ++i) {
                 emplace_thread();
             }
         }
@@ -26,29 +201,62 @@ public:
         }
     }
 
+    /**
+     * @brief Construct a pool with a scheduling mode.
+     *
+     * With `scheduling::work_stealing` every worker is started here and owns a Chase-Lev deque.
+     * Tasks enqueued from a worker go to the bottom of its own deque and run last in, first out,
+     * those from other threads go through a shared queue. An idle worker steals the oldest task of
+     * another one, starting from a random victim, spins for a while and finally parks until new
+     * work is enqueued.
+     * @param cores Cores to pin the workers to, worker `i` to `cores[i % cores.size()]`. Empty
+     * leaves them free. Only applies on Linux, a core that does not exist is ignored.
+     */
+    thread_pool(
+        const std::size_t num_threads, const scheduling mode,
+        const std::span<const std::uint32_t> cores = {})
+        : mode_(mode), num_threads_(std::max<std::size_t>(num_threads, 1)),
+          cores_(cores.begin(), cores.end()) {
+        if (mode_ == scheduling::shared_queue) {
+            inboxes_.resize(num_threads_);
+            try {
+                for (std::uint32_t i = 0; i < num_threads_ / 2; ++i) {
+                    emplace_thread();
+                }
+            }
+            catch (...) {
+                threads_.clear();
+                num_threads_ = 0;
+                throw;
+            }
+            return;
+        }
+
+        for (std::uint32_t i = 0; i < num_threads_; ++i) {
+            // any odd seed keeps xorshift away from zero.
+            workers_.emplace_back(std::make_unique<worker>(this, i * 2 + 1));
+        }
+        try {
+            for (auto& entry : workers_) {
+                threads_.emplace_back([this, &entry, index = threads_.size()]() {
+                    pin(index);
+                    steal_loop(*entry);
+                });
+            }
+        }
+        catch (...) {
+            stop();
+            throw;
+        }
+    }
+
     thread_pool(const thread_pool&) = delete;
     thread_pool(thread_pool&&)      = delete;
 
     thread_pool& operator=(const thread_pool&) = delete;
     thread_pool& operator=(thread_pool&&)      = delete;
 
-    ~thread_pool() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            stop_ = true;
-        }
-
-        condvar_.notify_all();
-
-        // jthread
-#if !defined(__cpp_lib_jthread)
-        for (auto& thread : threads_) {
-            if (thread.joinable()) {
-                thread.join();
-            }
-        }
-#endif
-    }
+    ~thread_pool() { stop(); }
 
     /**
      * @brief Add a new task to the queue.
@@ -62,49 +270,399 @@ public:
     template <typename Callable, typename... Args>
     auto enqueue(Callable&& callable, Args&&... args)
         -> std::future<std::invoke_result_t<Callable, Args...>> {
-        using return_type = std::invoke_result_t<Callable, Args...>;
+        return enqueue(task_hint{}, std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
 
-        if (stop_) [[unlikely]] {
-            throw std::runtime_error("enqueue on stopped thread pool");
+    /**
+     * @brief Add a new task to the queue, with a priority or a worker to run on.
+     *
+     */
+    template <typename Callable, typename... Args>
+    auto enqueue(const task_hint hint, Callable&& callable, Args&&... args)
+        -> std::future<std::invoke_result_t<Callable, Args...>> {
+        std::promise<std::invoke_result_t<Callable, Args...>> promise;
+        auto future = promise.get_future();
+        submit_detached(
+            hint,
+            [promise = std::move(promise), func = std::forward<Callable>(callable),
+             ... args = std::forward<Args>(args)]() mutable { fulfil(promise, func, args...); });
+        return future;
+    }
+
+    /**
+     * @brief Add a new task whose result is read through a pooled `task_future`.
+     *
+     * Unlike `enqueue`, nothing is allocated with `operator new` when the task fits in a
+     * `unique_task`.
+     */
+    template <typename Callable, typename... Args>
+    auto submit(Callable&& callable, Args&&... args)
+        -> task_future<std::invoke_result_t<Callable, Args...>> {
+        return submit(task_hint{}, std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Add a new task read through a `task_future`, with a priority or a worker to run on.
+     *
+     */
+    template <typename Callable, typename... Args>
+    auto submit(const task_hint hint, Callable&& callable, Args&&... args)
+        -> task_future<std::invoke_result_t<Callable, Args...>> {
+        task_promise<std::invoke_result_t<Callable, Args...>> promise;
+        auto future = promise.get_future();
+        submit_detached(
+            hint,
+            [promise = std::move(promise), func = std::forward<Callable>(callable),
+             ... args = std::forward<Args>(args)]() mutable { fulfil(promise, func, args...); });
+        return future;
+    }
+
+    /**
+     * @brief Add a new task nobody waits for.
+     *
+     * The callable and the arguments are copied into a `unique_task`, so a small task costs no
+     * allocation once the queues are warm. An exception escaping the task terminates the program.
+     */
+    template <typename Callable, typename... Args>
+    requires(!std::is_same_v<std::remove_cvref_t<Callable>, task_hint>)
+    void submit_detached(Callable&& callable, Args&&... args) {
+        submit_detached(task_hint{}, std::forward<Callable>(callable), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Add a new task nobody waits for, with a priority or a worker to run on.
+     *
+     */
+    template <typename Callable, typename... Args>
+    void submit_detached(const task_hint hint, Callable&& callable, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            push(unique_task{ std::forward<Callable>(callable) }, hint);
+        }
+        else {
+            push(
+                unique_task{ [func = std::forward<Callable>(callable),
+                              ... args = std::forward<Args>(args)]() mutable {
+                    std::invoke(func, args...);
+                } },
+                hint);
         }
+    }
+
+    [[nodiscard]] auto mode() const noexcept -> scheduling { return mode_; }
+
+    /**
+     * @brief Number of workers the pool runs once fully started.
+     *
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return num_threads_; }
 
-        if (threads_.size() ^ num_threads_) {
-            emplace_thread();
+private:
+    template <typename Promise, typename Func, typename... Args>
+    static void fulfil(Promise& promise, Func& func, Args&... args) {
+        try {
+            if constexpr (std::is_void_v<std::invoke_result_t<Func&, Args&...>>) {
+                std::invoke(func, args...);
+                promise.set_value();
+            }
+            else {
+                promise.set_value(std::invoke(func, args...));
+            }
         }
+        catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
 
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<Callable>(callable), std::forward<Args>(args)...));
+    void push(unique_task&& task, const task_hint hint) {
+        // workers may still add tasks while the pool drains.
+        if (stop_ && current_pool_ != this) [[unlikely]] {
+            throw std::runtime_error("enqueue on stopped thread pool");
+        }
 
-        std::future<return_type> future = task->get_future();
+        if (mode_ == scheduling::work_stealing) {
+            push_stealing(std::move(task), hint);
+            return;
+        }
 
+        auto hinted = hint.worker != task_hint::any_worker && num_threads_ != 0;
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            tasks_.emplace([task]() { (*task)(); });
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (hinted) {
+                const auto index = hint.worker % num_threads_;
+                while (!stop_ && threads_.size() <= index) {
+                    emplace_thread();
+                }
+                // once the pool stops, the worker may already have left. The shared lanes are
+                // drained by the caller, a worker itself.
+                hinted = !stop_;
+                if (hinted) {
+                    inboxes_[index].push(std::move(task));
+                }
+            }
+            else if (!stop_ && threads_.size() < num_threads_) {
+                emplace_thread();
+            }
+            if (!hinted) {
+                tasks_.push(std::move(task), hint.priority);
+            }
+        }
+        if (hinted) {
+            condvar_.notify_all();
+        }
+        else {
+            condvar_.notify_one();
         }
-        condvar_.notify_one();
-
-        return future;
     }
 
-private:
     void emplace_thread() {
-        threads_.emplace_back([this]() {
+        threads_.emplace_back([this, index = threads_.size()]() {
+            current_pool_ = this;
+            pin(index);
+            auto& inbox = inboxes_[index];
             while (true) {
                 std::unique_lock<std::mutex> lock(mutex_);
-                condvar_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                condvar_.wait(
+                    lock, [this, &inbox]() { return stop_ || !inbox.empty() || !tasks_.empty(); });
 
-                if (stop_ && tasks_.empty()) {
+                if (stop_ && inbox.empty() && tasks_.empty()) {
                     return;
                 }
 
-                auto task{ std::move(tasks_.front()) };
-                tasks_.pop();
+                auto task = inbox.empty() ? tasks_.pop() : inbox.pop();
                 lock.unlock();
                 task();
             }
         });
     }
 
+    /**
+     * @brief Pin the calling worker to its core, if cores were given.
+     *
+     */
+    void pin(const std::size_t index) const noexcept {
+#if defined(__linux__)
+        if (cores_.empty()) {
+            return;
+        }
+        const auto core = cores_[index % cores_.size()];
+        if (core >= CPU_SETSIZE) {
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        // a core outside of the process affinity mask is refused, the worker then stays free.
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+        (void)index;
+#endif
+    }
+
+    /**
+     * @brief Stop accepting tasks, let the workers drain what is left and join them.
+     *
+     */
+    void stop() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        condvar_.notify_all();
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_all();
+
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void push_stealing(unique_task&& func, const task_hint hint) {
+        auto* const task  = std::construct_at(nodes_.allocate<unique_task>(), std::move(func));
+        const auto hinted = hint.worker != task_hint::any_worker;
+        try {
+            if (hinted) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stop_.load(std::memory_order_relaxed)) {
+                    // the worker may already have left, the caller drains the lanes itself.
+                    injected_.push(task, hint.priority);
+                    injected_count_.fetch_add(1, std::memory_order_relaxed);
+                    urgent_count_.store(
+                        injected_.size(task_priority::high), std::memory_order_relaxed);
+                }
+                else {
+                    auto& target = *workers_[hint.worker % workers_.size()];
+                    std::lock_guard<std::mutex> inbox_lock(target.inbox_mutex);
+                    target.inbox.push(task);
+                    target.inbox_count.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            else if (
+                hint.priority == task_priority::normal && current_ != nullptr &&
+                current_->pool == this) {
+                current_->deque.push(task);
+            }
+            else {
+                // other priorities always go through the lanes, seen by every worker.
+                std::lock_guard<std::mutex> lock(mutex_);
+                injected_.push(task, hint.priority);
+                injected_count_.fetch_add(1, std::memory_order_relaxed);
+                urgent_count_.store(
+                    injected_.size(task_priority::high), std::memory_order_relaxed);
+            }
+        }
+        catch (...) {
+            recycle(task);
+            throw;
+        }
+
+        // pairs with the registration of a parking worker, see `steal_loop`.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) != 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            if (hinted) {
+                epoch_.notify_all();
+            }
+            else {
+                epoch_.notify_one();
+            }
+        }
+    }
+
+    [[nodiscard]] static auto pop_inbox(worker& self) -> unique_task* {
+        if (self.inbox_count.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(self.inbox_mutex);
+        if (self.inbox.empty()) {
+            return nullptr;
+        }
+        self.inbox_count.fetch_sub(1, std::memory_order_relaxed);
+        return self.inbox.pop();
+    }
+
+    [[nodiscard]] auto pop_injected() -> unique_task* {
+        if (injected_count_.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (injected_.empty()) {
+            return nullptr;
+        }
+        injected_count_.fetch_sub(1, std::memory_order_relaxed);
+        auto* const task = injected_.pop();
+        urgent_count_.store(injected_.size(task_priority::high), std::memory_order_relaxed);
+        return task;
+    }
+
+    [[nodiscard]] auto steal_from_others(worker& self) -> unique_task* {
+        const auto count = workers_.size();
+        if (count < 2) {
+            return nullptr;
+        }
+
+        // xorshift64
+        self.seed ^= self.seed << 13;
+        self.seed ^= self.seed >> 7;
+        self.seed ^= self.seed << 17;
+        const auto first = static_cast<std::size_t>(self.seed % count);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto& victim = *workers_[(first + i) % count];
+            if (&victim != &self) {
+                if (auto* const stolen = victim.deque.steal()) {
+                    return stolen;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] auto find_task(worker& self) -> unique_task* {
+        if (auto* const hinted = pop_inbox(self)) {
+            return hinted;
+        }
+        // urgent tasks overtake the local deque.
+        if (urgent_count_.load(std::memory_order_relaxed) != 0) {
+            if (auto* const urgent = pop_injected()) {
+                return urgent;
+            }
+        }
+        if (auto* const local = self.deque.take()) {
+            return local;
+        }
+        if (auto* const injected = pop_injected()) {
+            return injected;
+        }
+        return steal_from_others(self);
+    }
+
+    void recycle(unique_task* const task) noexcept {
+        std::destroy_at(task);
+        nodes_.deallocate(task);
+    }
+
+    void run(unique_task* const task) {
+        (*task)();
+        recycle(task);
+    }
+
+    void steal_loop(worker& self) {
+        current_pool_ = this;
+        current_      = &self;
+        while (true) {
+            auto* task = find_task(self);
+            // spin briefly, then keep yielding so that busy workers sharing the core run.
+            for (auto round = 0; task == nullptr && round < k_spin_rounds; ++round) {
+                if (round < k_spin_rounds / 4) {
+                    for (auto i = 0; i < k_spin_rounds; ++i) {
+                        internal::cpu_relax();
+                    }
+                }
+                else {
+                    std::this_thread::yield();
+                }
+                task = find_task(self);
+            }
+            if (task != nullptr) {
+                run(task);
+                continue;
+            }
+
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto epoch = epoch_.load(std::memory_order_acquire);
+            task             = find_task(self);
+            if (task == nullptr) {
+                if (stop_.load(std::memory_order_acquire)) {
+                    // a hinted task pushed before the pool stopped may have landed in the inbox
+                    // after the look above, the stop is ordered after it by `mutex_`.
+                    task = find_task(self);
+                    if (task == nullptr) {
+                        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+                else {
+                    epoch_.wait(epoch, std::memory_order_acquire);
+                }
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (task != nullptr) {
+                run(task);
+            }
+        }
+        current_      = nullptr;
+        current_pool_ = nullptr;
+    }
+
+    inline static thread_local const thread_pool* current_pool_ = nullptr;
+    inline static thread_local worker* current_                 = nullptr;
+
+    scheduling mode_{ scheduling::shared_queue };
     std::atomic<bool> stop_{ false };
     uint32_t num_threads_;
     std::mutex mutex_;
@@ -114,7 +672,17 @@ private:
     std::vector<std::thread> threads_;
 #endif
     std::condition_variable condvar_;
-    std::queue<std::function<void()>> tasks_;
+    internal::priority_lanes<unique_task> tasks_;
+    std::vector<internal::ring_queue<unique_task>> inboxes_;
+    std::vector<std::uint32_t> cores_;
+
+    std::vector<std::unique_ptr<worker>> workers_;
+    synchronized_pool nodes_;
+    internal::priority_lanes<unique_task*> injected_;
+    std::atomic<std::size_t> injected_count_;
+    std::atomic<std::size_t> urgent_count_;
+    std::atomic<std::uint32_t> epoch_;
+    std::atomic<std::uint32_t> sleepers_;
 };
 
 } // namespace atom::utils
@@ -0,0 +1,176 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "core/langdef.hpp"
+
+namespace atom::utils {
+
+/*! @cond TURN_OFF_DOXYGEN */
+namespace internal {
+
+/**
+ * @brief Circular array of a `work_stealing_deque`, indexed by ever-growing positions.
+ *
+ */
+template <typename Ty>
+class circular_array {
+public:
+    explicit circular_array(const std::int64_t capacity)
+        : mask_(capacity - 1), slots_(std::make_unique<std::atomic<Ty*>[]>(capacity)) {}
+
+    [[nodiscard]] auto capacity() const noexcept -> std::int64_t { return mask_ + 1; }
+
+    [[nodiscard]] auto load(const std::int64_t index) const noexcept -> Ty* {
+        return slots_[index & mask_].load(std::memory_order_relaxed);
+    }
+
+    void store(const std::int64_t index, Ty* const value) noexcept {
+        slots_[index & mask_].store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief A copy twice as large holding the elements in [top, bottom).
+     *
+     */
+    [[nodiscard]] auto grow(const std::int64_t top, const std::int64_t bottom) const
+        -> std::unique_ptr<circular_array> {
+        auto array = std::make_unique<circular_array>(capacity() * 2);
+        for (auto index = top; index != bottom; ++index) {
+            array->store(index, load(index));
+        }
+        return array;
+    }
+
+private:
+    std::int64_t mask_;
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+    std::unique_ptr<std::atomic<Ty*>[]> slots_;
+};
+
+} // namespace internal
+/*! @endcond */
+
+/**
+ * @brief Chase-Lev work-stealing deque of pointers.
+ *
+ * The owning thread pushes and takes at the bottom, so it works on the most recent element first,
+ * while any other thread steals the oldest one from the top. Only a take racing with a steal for
+ * the last element pays for a CAS. Arrays outgrown by `push` are kept until the deque is destroyed,
+ * as a concurrent thief could still be reading them.
+ * @tparam Ty Type of the pointed elements, the deque never owns them.
+ */
+template <typename Ty>
+class work_stealing_deque {
+    using array_type = internal::circular_array<Ty>;
+
+public:
+    using value_type = Ty*;
+    using size_type  = std::size_t;
+
+    constexpr static size_type k_default_capacity = 256;
+
+    explicit work_stealing_deque(const size_type capacity = k_default_capacity)
+        : array_(nullptr) {
+        std::int64_t power = 1;
+        while (power < static_cast<std::int64_t>(capacity)) {
+            power *= 2;
+        }
+        arrays_.emplace_back(std::make_unique<array_type>(power));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque&)            = delete;
+    work_stealing_deque(work_stealing_deque&&)                 = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(work_stealing_deque&&)      = delete;
+    ~work_stealing_deque()                                     = default;
+
+    /**
+     * @brief Push an element at the bottom, owner only.
+     *
+     */
+    void push(Ty* const value) {
+        const auto bottom = bottom_.load(std::memory_order_relaxed);
+        const auto top    = top_.load(std::memory_order_acquire);
+        auto* array       = array_.load(std::memory_order_relaxed);
+        if (bottom - top > array->capacity() - 1) {
+            arrays_.emplace_back(array->grow(top, bottom));
+            array = arrays_.back().get();
+            array_.store(array, std::memory_order_release);
+        }
+        array->store(bottom, value);
+        // a release store rather than a fence, it is as cheap and sanitizers understand it.
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Take the most recently pushed element, owner only.
+     *
+     * @return The element, or nullptr if the deque is empty.
+     */
+    [[nodiscard]] auto take() noexcept -> Ty* {
+        const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        auto* const array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = top_.load(std::memory_order_relaxed);
+
+        Ty* value = nullptr;
+        if (top <= bottom) {
+            value = array->load(bottom);
+            if (top == bottom) {
+                // the last element, thieves may want it too.
+                if (!top_.compare_exchange_strong(
+                        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    value = nullptr;
+                }
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Steal the oldest element, from any thread.
+     *
+     * @return The element, or nullptr if the deque is empty or another thread won the race.
+     */
+    [[nodiscard]] auto steal() noexcept -> Ty* {
+        auto top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        auto* const array = array_.load(std::memory_order_acquire);
+        auto* const value = array->load(top);
+        if (!top_.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Whether the deque looks empty, exact only on the owning thread.
+     *
+     */
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<std::int64_t> top_{};
+    alignas(cache_line_size) std::atomic<std::int64_t> bottom_{};
+    std::atomic<array_type*> array_;
+    std::vector<std::unique_ptr<array_type>> arrays_;
+};
+
+} // namespace atom::utils
@@ -1,83 +1,45 @@
+#define ATOM_POOL_INSTRUMENTATION 1
 #include "memory.hpp"
-#include <chrono>
-#include <format>
+#include <array>
+#include <list>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 #include "memory/allocator.hpp"
-#include "memory/copy.hpp"
+#include "memory/instrumented_pool.hpp"
 #include "memory/pool.hpp"
 #include "memory/storage.hpp"
-#include "misc/timer.hpp"
+#include "structures/dense_map.hpp"
+#include "structures/linear.hpp"
+#include "structures/set.hpp"
 #include "output.hpp"
+#include "require.hpp"
 
 using namespace atom;
 using namespace atom::utils;
 
-int main() {
-    // fastcpy
-    {
-        timer timer;
-        auto& t = timer[""];
-
-        constexpr std::string_view vw = "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789"
-                                        "0123456789012345678901234567890123456789";
-        constexpr auto len            = vw.length();
-        std::vector<char> vec;
-        vec.reserve(len + 1);
-        constexpr auto run_times = 1000000000;
-        __builtin_prefetch(vw.data(), 0);
-        __builtin_prefetch(vec.data(), 1);
-        t.from_now();
-        for (auto i = 0; i < run_times; ++i) {
-            fastcpy(vec.data(), vw.data(), len);
-        }
-        auto elapsed = t.to_now();
-        println(std::format("elapsed: {}", elapsed));
-        if (vw != vec.data()) {
-            println("vw != vec.data()");
-        }
-
-        __builtin_prefetch(vw.data(), 0);
-        __builtin_prefetch(vec.data(), 1);
-        t.from_now();
-        for (auto i = 0; i < run_times; ++i) {
-            __builtin_memcpy(vec.data(), vw.data(), len);
-        }
-        elapsed = t.to_now();
-        println(std::format("elapsed: {}", elapsed));
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+/**
+ * @brief Frees a block of a pool during static destruction, after the thread-local caches of the
+ * main thread are gone.
+ *
+ */
+struct late_release {
+    explicit late_release(utils::synchronized_pool& pool)
+        : pool(&pool), block(pool.allocate<int>()) {}
+
+    late_release(const late_release&)            = delete;
+    late_release& operator=(const late_release&) = delete;
+
+    ~late_release() {
+        pool->deallocate(block);
+        pool->deallocate(pool->allocate<int>());
     }
+
+    utils::synchronized_pool* pool;
+    int* block;
+};
+
+int main() {
     // standard_allocator
     {
         auto allocator = utils::standard_allocator<int>{};
@@ -120,13 +82,320 @@ int main() {
         }
     }
 
-    // builtin_allocator
+    // unsynchronized_pool
+    {
+        utils::unsynchronized_pool pool;
+        auto shared = pool.get();
+
+        auto* small = shared->allocate<char>(3);
+        auto* other = shared->allocate<char>(16);
+        REQUIRES(small != other);
+        shared->deallocate(small, 3);
+        REQUIRES(shared->allocate<char>(5) == small);
+
+        struct alignas(64) line {
+            char bytes[64];
+        };
+        auto* aligned = shared->allocate<line>(2, std::align_val_t{ alignof(line) });
+        REQUIRES(reinterpret_cast<std::uintptr_t>(aligned) % alignof(line) == 0);
+        shared->deallocate(aligned, 2, std::align_val_t{ alignof(line) });
+
+        auto* large = shared->allocate<double>(4096);
+        large[4095] = 1.0;
+        shared->deallocate(large, 4096);
+
+        std::list<int, utils::unsync_allocator<int>> list{ utils::unsync_allocator<int>{ pool } };
+        for (auto i = 0; i < 10000; ++i) {
+            list.push_back(i);
+        }
+        list.remove_if([](const int val) { return val % 2 == 0; });
+        REQUIRES(list.size() == 5000);
+        REQUIRES(list.front() == 1);
+    }
+
+    // pool_backing
+    {
+        const utils::pool_backing backing{ .huge_pages = true, .numa_local = true };
+        utils::unsynchronized_pool pool{ backing };
+        auto shared = pool.get();
+        std::vector<std::uint64_t*> blocks;
+        for (auto i = 0; i < 10000; ++i) {
+            blocks.push_back(shared->allocate<std::uint64_t>(4));
+            *blocks.back() = static_cast<std::uint64_t>(i);
+        }
+        REQUIRES(*blocks[9999] == 9999);
+
+        constexpr auto large = 3 * utils::internal::huge_page_size;
+        auto* bytes          = shared->allocate<std::byte>(large);
+        if constexpr (utils::internal::can_map_pages) {
+            const auto address = reinterpret_cast<std::uintptr_t>(bytes);
+            REQUIRES(address % utils::internal::huge_page_size == 0);
+        }
+        bytes[0]         = std::byte{ 1 };
+        bytes[large - 1] = std::byte{ 1 };
+        shared->deallocate(bytes, large);
+
+        utils::synchronized_pool shared_pool{ backing };
+        auto* block = shared_pool.allocate<int>(3);
+        shared_pool.deallocate(block, 3);
+        auto* huge = shared_pool.allocate<double>(large / sizeof(double));
+        huge[0]    = 1.0;
+        shared_pool.deallocate(huge, large / sizeof(double));
+    }
+
+    // synchronized_pool
     {
-        utils::unique_storage<int, utils::builtin_storage_allocator<int>> storage;
-        storage = 114514;
-        print("value in storage:");
-        print(*storage.get());
-        newline();
+        utils::synchronized_pool pool;
+        auto* small = pool.allocate<char>(3);
+        pool.deallocate(small, 3);
+        REQUIRES(pool.allocate<char>(5) == small);
+        pool.deallocate(small, 5);
+
+        // blocks allocated by one thread and freed by another find their way back
+        constexpr auto count = 20000;
+        std::vector<std::uint64_t*> blocks(count);
+        std::thread producer([&] {
+            for (auto i = 0; i < count; ++i) {
+                blocks[i]  = pool.allocate<std::uint64_t>(2);
+                *blocks[i] = static_cast<std::uint64_t>(i);
+            }
+        });
+        producer.join();
+
+        std::vector<std::thread> consumers;
+        for (auto t = 0; t < 4; ++t) {
+            consumers.emplace_back([&, t] {
+                for (auto i = t; i < count; i += 4) {
+                    REQUIRES(*blocks[i] == static_cast<std::uint64_t>(i));
+                    pool.deallocate(blocks[i], 2);
+                }
+                for (auto i = 0; i < 1000; ++i) {
+                    pool.deallocate(pool.allocate<std::uint64_t>(2), 2);
+                }
+            });
+        }
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+
+        using line_allocator = utils::allocator<std::uint64_t, utils::synchronized_pool>;
+        std::vector<std::uint64_t, line_allocator> vector{ line_allocator{ pool } };
+        for (auto i = 0; i < 1000; ++i) {
+            vector.push_back(static_cast<std::uint64_t>(i));
+        }
+        REQUIRES(vector.back() == 999);
+
+        // the pool outlives every static object, like the one of task_promise.
+        static const late_release release{ *new utils::synchronized_pool };
+    }
+
+    // a short batch, flushed at thread exit, is counted as short by the thread taking it.
+    {
+        using cache_t   = utils::internal::synchronized_pool_cache;
+        const auto state =
+            std::make_shared<utils::internal::synchronized_pool_state>(utils::pool_backing{});
+        {
+            cache_t cache{ state };
+            (void)cache.allocate(0);
+        }
+
+        cache_t cache{ state };
+        (void)cache.allocate(0);
+        std::size_t length{};
+        for (const auto* block = cache.lists[0].head; block != nullptr; block = block->next) {
+            ++length;
+        }
+        REQUIRES(length == cache_t::batch_size(0) - 2);
+        REQUIRES(cache.lists[0].count == length);
+    }
+
+    // object_pool
+    {
+        utils::object_pool<int> pool;
+        // a helper of another size first, like the container proxy of debug builds on MSVC.
+        struct helper {
+            std::array<std::byte, 40> bytes;
+        };
+        utils::allocator<helper, utils::object_pool<int>> helpers{ pool };
+        auto* const proxy = helpers.allocate();
+
+        utils::unsync_list<int> list{ utils::unsync_node_allocator<int>{ pool } };
+        for (auto i = 0; i < 1000; ++i) {
+            list.push_back(i);
+        }
+        const auto slot = pool.get()->slot_size(sizeof(int) + 2 * sizeof(void*));
+        REQUIRES(slot >= sizeof(int) + 2 * sizeof(void*));
+        REQUIRES(reinterpret_cast<std::byte*>(&*std::next(list.begin())) -
+                     reinterpret_cast<std::byte*>(&list.front()) ==
+                 static_cast<std::ptrdiff_t>(slot));
+
+        auto* const node = &list.back();
+        list.pop_back();
+        list.push_front(-1);
+        REQUIRES(&list.front() == node);
+        helpers.deallocate(proxy);
+
+        // buckets are arrays and bypass the slots
+        utils::object_pool<int, utils::spin_lock> shared;
+        utils::sync_unordered_set<int> set{ 16, std::hash<int>{}, std::equal_to<int>{},
+                                            utils::sync_node_allocator<int>{ shared } };
+        for (auto i = 0; i < 1000; ++i) {
+            set.insert(i);
+        }
+        set.erase(500);
+        REQUIRES(set.size() == 999);
+        REQUIRES_FALSE(set.contains(500));
+    }
+
+    // instrumented_pool
+    {
+        utils::synchronized_pool upstream;
+        utils::instrumented_pool<utils::synchronized_pool> pool{ upstream };
+        using int_allocator =
+            utils::allocator<int, utils::instrumented_pool<utils::synchronized_pool>>;
+        {
+            std::vector<int, int_allocator> vector{ int_allocator{ pool } };
+            vector.resize(100);
+            auto* const bytes = pool.get()->allocate<char>(24);
+            const auto stats  = pool.snapshot();
+            REQUIRES(stats.live_bytes == 100 * sizeof(int) + 24);
+            REQUIRES(stats.allocations == 2);
+            REQUIRES(stats.types.size() == 2);
+            REQUIRES(stats.types.front().name == "int");
+            REQUIRES(stats.types.front().live_objects == 100);
+            REQUIRES(stats.classes.front().block_size == 32);
+            REQUIRES(stats.fragmentation > 0.0);
+            pool.get()->deallocate(bytes, 24);
+        }
+        const auto stats = pool.snapshot();
+        REQUIRES(stats.live_bytes == 0);
+        REQUIRES(stats.peak_bytes == 100 * sizeof(int) + 24);
+        REQUIRES(stats.deallocations == 2);
+        const auto json = stats.to_json();
+        REQUIRES(json.starts_with("{\"live_bytes\":0,\"peak_bytes\":424,"));
+        REQUIRES(json.find("{\"name\":\"char\",\"live_bytes\":0,\"live_objects\":0,") !=
+                 std::string::npos);
+    }
+
+    // monotonic_pool
+    {
+        alignas(16) std::byte scratch[1024];
+        utils::monotonic_pool pool{ scratch, sizeof(scratch) };
+        auto* first = pool.allocate<int>(4);
+        REQUIRES(static_cast<void*>(first) == static_cast<void*>(scratch));
+        pool.deallocate(first, 4);
+        REQUIRES(pool.allocate<int>(2) == first);
+        REQUIRES(pool.stats().bytes_allocated == 2 * sizeof(int));
+
+        alignas(16) std::byte other[256];
+        utils::monotonic_pool upstream{ other, sizeof(other) };
+        utils::instrumented_pool<utils::monotonic_pool> counted{ upstream };
+        REQUIRES(static_cast<void*>(counted.get()->allocate<int>()) == static_cast<void*>(other));
+
+        using int_allocator = utils::allocator<int, utils::monotonic_pool>;
+        std::vector<int, int_allocator> vector{ int_allocator{ pool } };
+        for (auto i = 0; i < 10000; ++i) {
+            vector.push_back(i);
+        }
+        REQUIRES(vector[9999] == 9999);
+        const auto stats = pool.stats();
+        REQUIRES(stats.buffers > 1);
+        REQUIRES(stats.peak_bytes >= 10000 * sizeof(int));
+
+        using pair_allocator = utils::allocator<std::pair<uint32_t, int>, utils::monotonic_pool>;
+        {
+            utils::dense_map<uint32_t, int, pair_allocator> map{ pair_allocator{ pool } };
+            for (uint32_t i = 0; i < 1000; ++i) {
+                map.emplace(i * 7, static_cast<int>(i));
+            }
+            REQUIRES(map.at(6993U) == 999);
+        }
+        vector = decltype(vector){ int_allocator{ pool } };
+
+        pool.reset();
+        REQUIRES(pool.stats().buffers == 2);
+        REQUIRES(pool.stats().allocations == 0);
+        auto* reused = pool.allocate<double>(1000);
+        REQUIRES(pool.stats().buffers == 2);
+        reused[999] = 1.0;
+
+        pool.release();
+        REQUIRES(pool.stats().buffers == 1);
+        REQUIRES(static_cast<void*>(pool.allocate<char>()) == static_cast<void*>(scratch));
+    }
+
+    // unique_storage inline
+    {
+        using storage_t = utils::unique_storage<std::array<int, 4>, std::allocator<int>, 16>;
+        static_assert(storage_t::is_inline);
+        using large_t = utils::unique_storage<std::array<int, 5>, std::allocator<int>, 16>;
+        static_assert(!large_t::is_inline);
+
+        storage_t storage;
+        REQUIRES_FALSE(storage);
+        REQUIRES(storage.get() == nullptr);
+        storage = std::array<int, 4>{ 1, 2, 3, 4 };
+        const auto* const address = static_cast<const void*>(storage.get());
+        REQUIRES(address >= static_cast<const void*>(&storage));
+        REQUIRES(address < static_cast<const void*>(&storage + 1));
+
+        storage_t moved{ std::move(storage) };
+        REQUIRES_FALSE(storage);
+        REQUIRES((*moved)[3] == 4);
+        REQUIRES(static_cast<const void*>(moved.get()) != address);
+
+        storage = std::move(moved);
+        REQUIRES((*storage)[0] == 1);
+        REQUIRES(static_cast<const void*>(storage.get()) == address);
+        REQUIRES(storage->at(2) == 3);
+        storage.reset();
+        REQUIRES_FALSE(storage);
+        REQUIRES(storage.get() == nullptr);
+    }
+
+    // shared_storage refcount
+    {
+        utils::synchronized_pool upstream;
+        utils::instrumented_pool<utils::synchronized_pool> pool{ upstream };
+        using pool_t    = utils::instrumented_pool<utils::synchronized_pool>;
+        using storage_t = utils::shared_storage<std::array<int, 4>,
+                                                utils::allocator<std::array<int, 4>, pool_t>,
+                                                utils::plain_refcount>;
+        using allocator_t = utils::allocator<std::array<int, 4>, pool_t>;
+        {
+            storage_t storage{ allocator_t{ pool } };
+            REQUIRES_FALSE(storage);
+            REQUIRES(storage.count() == 0);
+            storage = std::array<int, 4>{ 1, 2, 3, 4 };
+            REQUIRES(pool.snapshot().allocations == 1);
+
+            storage_t copy{ storage };
+            REQUIRES(storage.count() == 2);
+            REQUIRES(copy.get() == storage.get());
+
+            // copy on write
+            copy = std::array<int, 4>{ 5, 6, 7, 8 };
+            REQUIRES(storage.count() == 1);
+            REQUIRES(copy.count() == 1);
+            REQUIRES((*storage.get())[0] == 1);
+            REQUIRES((*copy.get())[0] == 5);
+
+            storage_t moved{ std::move(copy) };
+            REQUIRES_FALSE(copy);
+            REQUIRES(moved.count() == 1);
+            moved = storage;
+            REQUIRES(storage.count() == 2);
+            REQUIRES(pool.snapshot().live_bytes <= 2 * 32);
+        }
+        REQUIRES(pool.snapshot().live_bytes == 0);
+
+        utils::shared_storage<int> adopted{ new int{ 3 } };
+        utils::shared_storage<int> other{ adopted };
+        REQUIRES(adopted.count() == 2);
+        other.reset();
+        REQUIRES(adopted.count() == 1);
+        adopted.release();
+        REQUIRES_FALSE(adopted);
     }
 
     return 0;
@@ -1,8 +1,17 @@
 #include "structures.hpp"
 #include <memory_resource>
 #include <ranges>
+#include <span>
+#include <thread>
 #include <ranges/element_view.hpp>
+#include "structures/concurrent_dense_map.hpp"
+#include "structures/dense_group.hpp"
 #include "structures/dense_map.hpp"
+#include "structures/dense_set.hpp"
+#include "structures/join_view.hpp"
+#include "structures/soa_dense_map.hpp"
+#include "thread/lock.hpp"
+#include "require.hpp"
 
 using namespace atom::utils;
 
@@ -40,6 +49,351 @@ int main() {
         for (auto v : values) {}
     }
 
+    // concurrent_dense_map
+    {
+        concurrent_dense_map<uint32_t, int> map;
+        for (uint32_t i = 0; i < 1024; ++i) {
+            map.emplace(i * 3, static_cast<int>(i));
+        }
+        REQUIRES(map.size() == 1024);
+        REQUIRES_FALSE(map.emplace(3U, 0));
+        REQUIRES(map.erase(3U));
+        REQUIRES_FALSE(map.contains(3U));
+        REQUIRES(map.get(6U) == 2);
+
+        std::atomic<bool> stop{ false };
+        std::atomic<int> mismatches{ 0 };
+        std::thread reader([&] {
+            while (!stop.load()) {
+                for (uint32_t i = 2; i < 4096; ++i) {
+                    if (auto val = map.get(i * 3); val && *val != static_cast<int>(i)) {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+        for (uint32_t i = 1024; i < 4096; ++i) {
+            map.insert_or_assign(i * 3, static_cast<int>(i));
+        }
+        for (uint32_t i = 1024; i < 4096; ++i) {
+            map.erase(i * 3);
+        }
+        stop = true;
+        reader.join();
+        REQUIRES(mismatches == 0);
+        REQUIRES(map.size() == 1023);
+    }
+
+    // dense_map & dense_set with lock policies
+    {
+        dense_map<uint32_t, int, std::allocator<std::pair<uint32_t, int>>, 32, null_lock> map;
+        static_assert(sizeof(map) < sizeof(dense_map<uint32_t, int>));
+        REQUIRES(map.emplace(3U, 4).second);
+        REQUIRES_FALSE(map.emplace(3U, 5).second);
+        REQUIRES(map.at(3U) == 4);
+        map.emplace(0U, 1);
+        map.erase(3U);
+        REQUIRES_FALSE(map.contains(3U));
+        REQUIRES(map.contains(0U));
+
+        dense_set<uint32_t, std::allocator<uint32_t>, 32, spin_lock> set;
+        for (uint32_t i = 0; i < 100; ++i) {
+            set.emplace(i * 5);
+        }
+        set.emplace(5U);
+        REQUIRES(set.size() == 100);
+        set.erase(0U);
+        REQUIRES_FALSE(set.contains(0U));
+        REQUIRES(set.contains(495U));
+        REQUIRES(*set.find(495U) == 495U);
+        auto copy = set;
+        set.clear();
+        REQUIRES(copy.size() == 99);
+        REQUIRES(copy.contains(5U));
+
+        // assignment locks both sides through try_lock.
+        decltype(set) moved;
+        moved = std::move(copy);
+        REQUIRES(moved.size() == 99);
+
+        dense_map<uint32_t, int, std::allocator<std::pair<uint32_t, int>>, 32, spin_lock> source;
+        source.emplace(7U, 8);
+        decltype(source) target;
+        target = std::move(source);
+        REQUIRES(target.at(7U) == 8);
+
+        spin_lock lock;
+        REQUIRES(lock.try_lock());
+        REQUIRES_FALSE(lock.try_lock());
+        lock.unlock();
+    }
+
+    // dense_map batch operations
+    {
+        dense_map<uint32_t, int> map;
+        std::vector<std::pair<uint32_t, int>> pairs;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            pairs.emplace_back(i * 11, static_cast<int>(i));
+        }
+        pairs.emplace_back(0, -1);
+        REQUIRES(map.insert_range(pairs) == 1000);
+        REQUIRES(map.at(0U) == 0);
+
+        std::vector<uint32_t> keys{ 11, 12, 10989, 22 };
+        std::vector<decltype(map)::iterator> found(keys.size());
+        REQUIRES(map.find_many(keys, found) == 3);
+        REQUIRES(found[0]->second == 1);
+        REQUIRES(found[1] == map.end());
+        REQUIRES(found[2]->second == 999);
+
+        REQUIRES(map.erase_range(keys) == 3);
+        REQUIRES(map.size() == 997);
+        REQUIRES_FALSE(map.contains(22U));
+        REQUIRES(map.at(33U) == 3);
+
+        // random access but not sized.
+        auto below = std::views::iota(0U, 100U) |
+                     std::views::take_while([](const uint32_t key) { return key < 50; });
+        static_assert(std::ranges::random_access_range<decltype(below)>);
+        static_assert(!std::ranges::sized_range<decltype(below)>);
+        REQUIRES(map.erase_range(below) == 3);
+        REQUIRES_FALSE(map.contains(44U));
+        REQUIRES(map.at(55U) == 5);
+
+        // many small batches, the dense array grows geometrically.
+        dense_map<uint32_t, int> batched;
+        for (std::size_t first = 0; first < pairs.size(); first += 7) {
+            const auto count = std::min<std::size_t>(7, pairs.size() - first);
+            batched.insert_range(std::span{ pairs }.subspan(first, count));
+        }
+        REQUIRES(batched.size() == 1000);
+        REQUIRES(batched.at(0U) == 0);
+        REQUIRES(batched.at(10989U) == 999);
+    }
+
+    // dense_map sparse pages
+    {
+        dense_map<uint32_t, int> map;
+        map.emplace(10'000'000U, 1);
+        map.emplace(10'000'001U, 2);
+        map.emplace(3U, 3);
+        REQUIRES(map.page_count() == 2);
+        REQUIRES_FALSE(map.contains(64U));
+        REQUIRES(map.find(9'999'999U) == map.end());
+
+        auto copy = map;
+        REQUIRES(copy.page_count() == 2);
+        REQUIRES(copy.at(10'000'001U) == 2);
+
+        map.erase(10'000'000U);
+        REQUIRES(map.page_count() == 2);
+        map.erase(10'000'001U);
+        REQUIRES(map.page_count() == 1);
+        REQUIRES(map.at(3U) == 3);
+        map.shrink_to_fit();
+        REQUIRES(map.at(3U) == 3);
+        REQUIRES_FALSE(map.contains(10'000'001U));
+        map.emplace(10'000'001U, 4);
+        REQUIRES(map.at(10'000'001U) == 4);
+        map.erase(3U);
+        REQUIRES(map.page_count() == 1);
+        REQUIRES_FALSE(map.contains(3U));
+    }
+
+    // dense_map & dense_set inline pages
+    {
+        dense_map<uint32_t, int, std::allocator<std::pair<uint32_t, int>>, 32, null_lock, 0, true>
+            map;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            map.emplace(i * 5, static_cast<int>(i));
+        }
+        map.erase(5U);
+        REQUIRES(map.at(4995U) == 999);
+        REQUIRES_FALSE(map.contains(5U));
+
+        auto copy  = map;
+        auto moved = std::move(map);
+        REQUIRES(copy.at(10U) == 2);
+        REQUIRES(moved.at(10U) == 2);
+        moved.erase(10U);
+        REQUIRES(copy.contains(10U));
+
+        dense_set<uint32_t, std::allocator<uint32_t>, 32, null_lock, true> set;
+        for (uint32_t i = 0; i < 100; ++i) {
+            set.emplace(i * 64);
+        }
+        set.erase(64U);
+        REQUIRES(set.size() == 99);
+        REQUIRES(set.contains(6336U));
+        REQUIRES_FALSE(set.contains(64U));
+    }
+
+    // dense_map versioned keys
+    {
+        using map_t  = dense_map<uint32_t, int, std::allocator<std::pair<uint32_t, int>>, 32,
+                                 std::shared_mutex, 8>;
+        using traits = map_t::key_traits;
+        static_assert(traits::index_bits == 24);
+        static_assert(traits::version(traits::make(5, 255)) == 255);
+        static_assert(traits::next(traits::make(5, 255)) == traits::make(5, 0));
+
+        map_t map;
+        const auto first  = traits::make(0, 0);
+        const auto stale  = traits::make(7, 1);
+        const auto recent = traits::next(stale);
+        REQUIRES(map.emplace(first, 1).second);
+        REQUIRES(map.emplace(stale, 2).second);
+        REQUIRES_FALSE(map.emplace(recent, 3).second);
+        REQUIRES(map.contains(stale));
+        REQUIRES_FALSE(map.contains(recent));
+
+        map.erase(recent);
+        REQUIRES(map.contains(stale));
+        map.erase(stale);
+        REQUIRES(map.emplace(recent, 3).second);
+        REQUIRES_FALSE(map.contains(stale));
+        REQUIRES(map.find(stale) == map.end());
+        REQUIRES(map.find(recent)->second == 3);
+        REQUIRES_FALSE(map.contains(traits::next(first)));
+
+        map.erase(first);
+        REQUIRES(map.at(recent) == 3);
+        REQUIRES(map.begin()->first == recent);
+    }
+
+    // dense_map sorting and groups
+    {
+        dense_map<uint32_t, int> positions;
+        dense_map<uint32_t, float> speeds;
+        for (uint32_t key : { 9U, 2U, 40U, 7U, 3U }) {
+            positions.emplace(key, static_cast<int>(key));
+        }
+        for (uint32_t key : { 3U, 100U, 9U, 40U }) {
+            speeds.emplace(key, static_cast<float>(key));
+        }
+
+        positions.sort();
+        REQUIRES(std::ranges::is_sorted(positions | std::views::keys));
+        REQUIRES(positions.at(40U) == 40);
+        positions.sort([](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+        REQUIRES(positions.begin()->first == 40U);
+        REQUIRES(positions.find(7U)->second == 7);
+
+        REQUIRES(speeds.sort_as(positions) == 3);
+        REQUIRES(speeds.begin()[0].first == 40U);
+        REQUIRES(speeds.begin()[1].first == 9U);
+        REQUIRES(speeds.begin()[2].first == 3U);
+        REQUIRES(speeds.at(100U) == 100.F);
+
+        dense_group group{ positions, speeds };
+        REQUIRES(group.size() == 3);
+        const auto check = [&] {
+            for (size_t i = 0; i < group.size(); ++i) {
+                REQUIRES(positions.begin()[i].first == speeds.begin()[i].first);
+            }
+        };
+        check();
+
+        positions.emplace(100U, 100);
+        REQUIRES(group.track(100U));
+        REQUIRES_FALSE(group.track(100U));
+        REQUIRES(group.size() == 4);
+        check();
+
+        REQUIRES(group.untrack(9U));
+        positions.erase(9U);
+        REQUIRES(group.size() == 3);
+        check();
+
+        int sum{};
+        group.each([&](const uint32_t key, int& position, float& speed) {
+            REQUIRES(static_cast<float>(position) == speed);
+            sum += static_cast<int>(key);
+        });
+        REQUIRES(sum == 143);
+        REQUIRES_FALSE(group.contains(9U));
+        REQUIRES(group.contains(3U));
+    }
+
+    // join_view
+    {
+        dense_map<uint32_t, int> positions;
+        dense_map<uint32_t, float> speeds;
+        dense_set<uint32_t> alive;
+        for (uint32_t i = 0; i < 10000; ++i) {
+            positions.emplace(i, static_cast<int>(i));
+            if (i % 2 == 0) {
+                speeds.emplace(i, 1.F);
+            }
+            if (i % 3 == 0) {
+                alive.emplace(i);
+            }
+        }
+
+        const auto& cspeeds = speeds;
+        auto view           = join(positions, cspeeds, alive);
+        static_assert(std::is_same_v<
+                      decltype(view)::value_type, std::tuple<uint32_t, int&, const float&>>);
+        REQUIRES(view.size_hint() == alive.size());
+
+        size_t count{};
+        for (auto [key, position, speed] : view) {
+            REQUIRES(key % 6 == 0);
+            REQUIRES(position == static_cast<int>(key));
+            REQUIRES(speed == 1.F);
+            ++count;
+        }
+        REQUIRES(count == 1667);
+
+        view.each([](uint32_t, int& position, const float& speed) {
+            position += static_cast<int>(speed);
+        });
+        REQUIRES(positions.at(6U) == 7);
+        REQUIRES(positions.at(7U) == 7);
+
+        thread_pool pool(4);
+        std::atomic<size_t> visited{};
+        view.parallel_each(
+            pool,
+            [&](uint32_t, int& position, const float&) {
+                ++position;
+                ++visited;
+            },
+            64);
+        REQUIRES(visited == 1667);
+        REQUIRES(positions.at(9996U) == 9998);
+    }
+
+    // soa_dense_map
+    {
+        soa_dense_map<uint32_t, float> map{
+            { 1, 1.F },
+            { 7, 7.F },
+            { 9, 9.F }
+        };
+        REQUIRES(map.emplace(64U, 64.F).second);
+        REQUIRES_FALSE(map.emplace(7U, 0.F).second);
+        for (auto& value : map.values()) {
+            value *= 2.F;
+        }
+        REQUIRES(map.at(64U) == 128.F);
+        REQUIRES(map.erase(1U));
+        REQUIRES_FALSE(map.contains(1U));
+        REQUIRES(map.keys().size() == map.values().size());
+        for (auto [key, value] : map) {
+            REQUIRES(value == static_cast<float>(key) * 2.F);
+        }
+        REQUIRES((*map.find(9U)).second == 18.F);
+        static_assert(std::random_access_iterator<decltype(map)::iterator>);
+
+        soa_dense_map<uint32_t, float, std::allocator<std::pair<uint32_t, float>>, 32, spin_lock>
+            source;
+        source.emplace(5U, 5.F);
+        decltype(source) target;
+        target = std::move(source);
+        REQUIRES(target.at(5U) == 5.F);
+    }
+
     // dense_set
 
     return 0;
@@ -1,8 +1,29 @@
 #include "thread.hpp"
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <latch>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+#include "memory/allocator.hpp"
+#include "memory/pool.hpp"
 #include "output.hpp"
+#include "structures/dense_map.hpp"
+#include "structures/dense_set.hpp"
 #include "thread/coroutine.hpp"
+#include "thread/parallel.hpp"
+#include "thread/task.hpp"
+#include "thread/task_graph.hpp"
 #include "thread/thread_pool.hpp"
+#include "thread/work_stealing_deque.hpp"
+#include "require.hpp"
 
 using namespace atom::utils;
 
@@ -14,6 +35,125 @@ coroutine<int> number_generator() {
     }
 }
 
+template <typename Ty>
+struct counting_allocator {
+    using value_type = Ty;
+
+    counting_allocator(int& allocated, int& freed) noexcept
+        : allocated(&allocated), freed(&freed) {}
+
+    template <typename Other>
+    counting_allocator(const counting_allocator<Other>& that) noexcept
+        : allocated(that.allocated), freed(that.freed) {}
+
+    auto allocate(const std::size_t count) -> Ty* {
+        ++*allocated;
+        return std::allocator<Ty>{}.allocate(count);
+    }
+
+    void deallocate(Ty* const ptr, const std::size_t count) noexcept {
+        ++*freed;
+        std::allocator<Ty>{}.deallocate(ptr, count);
+    }
+
+    int* allocated;
+    int* freed;
+};
+
+template <typename Alloc>
+coroutine<int> allocated_generator(std::allocator_arg_t, const Alloc&, const int first) {
+    for (auto current = first;; ++current) {
+        co_yield current;
+    }
+}
+
+struct stepper {
+    template <typename Alloc>
+    coroutine<int> steps(std::allocator_arg_t, const Alloc&) const {
+        for (auto current = 0;; current += step) {
+            co_yield current;
+        }
+    }
+
+    int step;
+};
+
+/**
+ * @brief Destroys a coroutine and starts another one during static destruction, after the frame
+ * cache of the main thread is gone, and frees a frame allocated then on another thread.
+ *
+ */
+struct late_generator {
+    late_generator() : generator(number_generator<void>()) {}
+
+    late_generator(const late_generator&)            = delete;
+    late_generator& operator=(const late_generator&) = delete;
+
+    ~late_generator() {
+        auto another = number_generator<void>();
+        another.get();
+
+        // sized exactly, then freed where a cache lives, which must not hand it out for more.
+        auto* const frame = internal::pooled_frame::operator new(1);
+        std::thread{ [frame] {
+            internal::pooled_frame::operator delete(frame, 1);
+            auto* const larger = internal::pooled_frame::operator new(48);
+            std::memset(larger, 0, 48);
+            internal::pooled_frame::operator delete(larger, 48);
+        } }.join();
+    }
+
+    coroutine<int> generator;
+};
+
+coroutine<std::unique_ptr<int>> owning_generator() {
+    for (auto current = 0;; ++current) {
+        co_yield std::make_unique<int>(current);
+    }
+}
+
+thread_safe_coroutine<int> shared_counter(const int limit) {
+    for (auto value = 0; value < limit; ++value) {
+        co_yield value;
+    }
+    co_return -1;
+}
+
+thread_safe_coroutine<int> failing_counter() {
+    co_yield 0;
+    throw std::runtime_error("expected");
+}
+
+task<int> add_on(atom::utils::thread_pool& pool, const int lhs, const int rhs) {
+    co_await schedule_on(pool);
+    co_return lhs + rhs;
+}
+
+task<int> add_twice(atom::utils::thread_pool& pool, std::thread::id& resumed_on) {
+    const auto first  = co_await add_on(pool, 1, 2);
+    const auto second = co_await add_on(pool, first, 3);
+    resumed_on        = std::this_thread::get_id();
+    co_return second;
+}
+
+task<> fail_on(atom::utils::thread_pool& pool) {
+    co_await schedule_on(pool);
+    throw std::runtime_error("expected");
+}
+
+task<int> count_down(const int depth) {
+    if (depth == 0) {
+        co_return 0;
+    }
+    co_return 1 + co_await count_down(depth - 1);
+}
+
+eager_task<int> started_eagerly(atom::utils::thread_pool& pool, std::atomic<bool>& started) {
+    started = true;
+    co_await schedule_on(pool, { .priority = task_priority::high });
+    co_return 42;
+}
+
 int main() {
     thread_pool thread_pool;
 
@@ -25,6 +165,495 @@ int main() {
         }
     }
 
+    // coroutine frames
+    {
+        int allocated{};
+        int freed{};
+        {
+            const counting_allocator<std::byte> alloc{ allocated, freed };
+            auto generator = allocated_generator(std::allocator_arg, alloc, 5);
+            REQUIRES(generator.get() == 5);
+            REQUIRES(generator.get() == 6);
+
+            const stepper stepper{ 3 };
+            auto steps = stepper.steps(std::allocator_arg, alloc);
+            REQUIRES(steps.get() == 0);
+            REQUIRES(steps.get() == 3);
+        }
+        REQUIRES(allocated == 2);
+        REQUIRES(freed == 2);
+
+        unsynchronized_pool pool;
+        const allocator<std::byte, unsynchronized_pool> alloc{ pool };
+        for (auto i = 0; i < 100; ++i) {
+            auto generator = allocated_generator(std::allocator_arg, alloc, i);
+            REQUIRES(generator.get() == i);
+        }
+
+        // frames recycled by the cache of this thread.
+        for (auto i = 0; i < 100; ++i) {
+            auto generator = number_generator<void>();
+            REQUIRES(generator.get() == 0);
+            REQUIRES(generator.get() == 1);
+        }
+
+        auto owning = owning_generator();
+        REQUIRES(*owning.get() == 0);
+        REQUIRES(*owning.get() == 1);
+
+        static late_generator late;
+        REQUIRES(late.generator.get() == 0);
+    }
+
+    // parallel_for_each
+    {
+        dense_map<uint32_t, float> map;
+        for (uint32_t i = 0; i < 100000; ++i) {
+            map.emplace(i * 3, 1.F);
+        }
+        parallel_for_each(map, [](auto& pair) { pair.second *= 2.F; }, thread_pool, 1000);
+        REQUIRES(map.at(3U) == 2.F);
+        REQUIRES(map.at(299997U) == 2.F);
+
+        dense_set<uint32_t> set;
+        for (uint32_t i = 0; i < 5000; ++i) {
+            set.emplace(i);
+        }
+        std::atomic<uint64_t> sum{};
+        parallel_for_each(set, [&](const uint32_t val) { sum += val; }, thread_pool, 7);
+        REQUIRES(sum == 4999ULL * 5000 / 2);
+
+        bool thrown{};
+        try {
+            parallel_for_each(
+                set,
+                [](const uint32_t val) {
+                    if (val == 4000) {
+                        throw std::runtime_error("expected");
+                    }
+                },
+                thread_pool, 16);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        REQUIRES(thrown);
+    }
+
+    // work_stealing_deque
+    {
+        std::vector<int> values(1000);
+        work_stealing_deque<int> deque{ 4 };
+        REQUIRES(deque.take() == nullptr);
+        REQUIRES(deque.steal() == nullptr);
+        for (auto& value : values) {
+            deque.push(&value);
+        }
+        REQUIRES(deque.take() == &values.back());
+        REQUIRES(deque.steal() == &values.front());
+        REQUIRES(deque.steal() == &values[1]);
+        for (auto i = 998; i > 1; --i) {
+            REQUIRES(deque.take() == &values[i]);
+        }
+        REQUIRES(deque.empty());
+        REQUIRES(deque.take() == nullptr);
+    }
+
+    // work stealing
+    {
+        std::atomic<int> leaves{};
+        std::function<void(int)> fork;
+        {
+            atom::utils::thread_pool pool{ 4, scheduling::work_stealing };
+            REQUIRES(pool.mode() == scheduling::work_stealing);
+
+            // every task forks two more from its worker until the depth runs out.
+            fork = [&](const int depth) {
+                if (depth == 0) {
+                    leaves.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                pool.enqueue(fork, depth - 1);
+                pool.enqueue(fork, depth - 1);
+            };
+            pool.enqueue(fork, 10);
+
+            auto add    = [](const int lhs, const int rhs) { return lhs + rhs; };
+            auto future = pool.enqueue(add, 1, 2);
+            REQUIRES(future.get() == 3);
+
+            auto failed = pool.enqueue([]() { throw std::runtime_error("expected"); });
+            bool thrown{};
+            try {
+                failed.get();
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            REQUIRES(thrown);
+        }
+        // the pool runs every task left before its workers leave.
+        REQUIRES(leaves.load() == 1 << 10);
+    }
+
+    // unique_task
+    {
+        int calls{};
+        unique_task small{ [&calls]() { ++calls; } };
+        static_assert(unique_task::fits_inline<decltype([&calls]() { ++calls; })>);
+        std::array<int, 32> payload{};
+        payload.back() = 2;
+        unique_task large{ [&calls, payload]() { calls += payload.back(); } };
+        static_assert(sizeof(unique_task) == 64);
+
+        unique_task moved{ std::move(small) };
+        REQUIRES_FALSE(small);
+        moved();
+        large();
+        small = std::move(large);
+        small();
+        REQUIRES(calls == 5);
+        small.reset();
+        REQUIRES_FALSE(small);
+    }
+
+    // task_promise & task_future
+    {
+        task_promise<int> promise;
+        auto future = promise.get_future();
+        REQUIRES_FALSE(future.ready());
+        promise.set_value(42);
+        REQUIRES(future.ready());
+        REQUIRES(future.get() == 42);
+        REQUIRES_FALSE(future.valid());
+
+        task_future<void> broken;
+        {
+            task_promise<void> dropped;
+            broken = dropped.get_future();
+        }
+        bool thrown{};
+        try {
+            broken.get();
+        }
+        catch (const std::future_error& error) {
+            thrown = error.code() == std::future_errc::broken_promise;
+        }
+        REQUIRES(thrown);
+    }
+
+    // submit & submit_detached
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        std::atomic<int> count{};
+        {
+            atom::utils::thread_pool pool{ 4, mode };
+            for (auto i = 0; i < 1000; ++i) {
+                pool.submit_detached([&count](const int step) { count += step; }, 1);
+            }
+            auto future = pool.submit([](const int lhs, const int rhs) { return lhs * rhs; }, 6, 7);
+            REQUIRES(future.get() == 42);
+
+            auto failed = pool.submit([]() -> int { throw std::runtime_error("expected"); });
+            bool thrown{};
+            try {
+                failed.get();
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            REQUIRES(thrown);
+        }
+        REQUIRES(count.load() == 1000);
+    }
+
+    // parallel algorithms
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        atom::utils::thread_pool pool{ 4, mode };
+
+        for (const auto split : { partitioning::static_split, partitioning::dynamic }) {
+            std::vector<int> hits(10007);
+            parallel_for(0, 10007, [&hits](const int index) { ++hits[index]; }, pool, 100, split);
+            REQUIRES(std::ranges::all_of(hits, [](const int hit) { return hit == 1; }));
+
+            parallel_for(hits, [](int& hit) { hit *= 3; }, pool, 1, split);
+            REQUIRES(std::ranges::all_of(hits, [](const int hit) { return hit == 3; }));
+        }
+
+        std::vector<uint64_t> values(100003);
+        std::iota(values.begin(), values.end(), 1);
+        const auto sum = parallel_reduce(values, uint64_t{ 5 }, std::plus<>{}, pool, 1000);
+        REQUIRES(sum == 100003ULL * 100004 / 2 + 5);
+        REQUIRES(parallel_reduce(std::vector<int>{}, 7, std::plus<>{}, pool) == 7);
+
+        // not commutative, the blocks must be folded in order.
+        std::vector<std::string> words(1000);
+        for (auto i = 0; i < 1000; ++i) {
+            words[i] = std::string(1, static_cast<char>('a' + i % 26));
+        }
+        auto joined = parallel_reduce(words, std::string{}, std::plus<>{}, pool, 10);
+        REQUIRES(joined == std::accumulate(words.begin(), words.end(), std::string{}));
+
+        std::vector<uint64_t> scanned(values.size());
+        auto end = parallel_inclusive_scan(values, scanned.begin(), std::plus<>{}, pool, 1000);
+        REQUIRES(end == scanned.end());
+        std::vector<uint64_t> expected(values.size());
+        std::inclusive_scan(values.begin(), values.end(), expected.begin());
+        REQUIRES(scanned == expected);
+        parallel_inclusive_scan(values, values.begin(), std::plus<>{}, pool, 7);
+        REQUIRES(values == expected);
+
+        std::vector<uint32_t> keys(100003);
+        uint32_t state = 1;
+        for (auto& key : keys) {
+            state = state * 1664525U + 1013904223U;
+            key   = state >> 12;
+        }
+        auto sorted = keys;
+        std::ranges::sort(sorted);
+        parallel_sort(keys, pool, 1000);
+        REQUIRES(keys == sorted);
+        parallel_sort(keys, std::ranges::greater{}, pool, 7);
+        REQUIRES(std::ranges::equal(keys, sorted | std::views::reverse));
+
+        // element-wise exceptions reach the caller.
+        bool thrown{};
+        try {
+            parallel_for(
+                0, 1000,
+                [](const int index) {
+                    if (index == 500) {
+                        throw std::runtime_error("expected");
+                    }
+                },
+                pool, 10, partitioning::dynamic);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        REQUIRES(thrown);
+    }
+
+    // task_graph
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        atom::utils::thread_pool pool{ 4, mode };
+
+        // a diamond a -> (b, c) -> d, then a long chain d -> e -> f.
+        std::array<std::atomic<int>, 6> finished{};
+        std::atomic<int> clock{};
+        std::atomic<bool> ordered{ true };
+        task_graph graph;
+        const auto stamp = [&](const std::size_t node, std::initializer_list<std::size_t> after) {
+            for (const auto before : after) {
+                if (finished[before].load() == 0) {
+                    ordered = false;
+                }
+            }
+            finished[node] = ++clock;
+        };
+        const auto a = graph.emplace("a", [&] { stamp(0, {}); });
+        const auto b = graph.emplace("b", [&] { stamp(1, { 0 }); });
+        const auto c = graph.emplace("c", [&] { stamp(2, { 0 }); });
+        const auto d = graph.emplace("d", [&] { stamp(3, { 1, 2 }); });
+        const auto e = graph.emplace("e", [&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            stamp(4, { 3 });
+        });
+        const auto f = graph.emplace("f", [&] { stamp(5, { 4 }); });
+        graph.precede(a, b);
+        graph.precede(a, c);
+        graph.precede(b, d);
+        graph.precede(c, d);
+        graph.precede(d, e);
+        graph.precede(e, f);
+
+        // the same graph runs again without being rebuilt.
+        for (auto round = 0; round < 3; ++round) {
+            for (auto& node : finished) {
+                node = 0;
+            }
+            graph.run(pool);
+            REQUIRES(ordered.load());
+            REQUIRES(std::ranges::all_of(finished, [](const auto& node) { return node > 0; }));
+        }
+
+        const auto timings = graph.timings();
+        REQUIRES(timings.nodes.size() == 6);
+        REQUIRES(timings.critical_path.size() == 5);
+        REQUIRES(timings.critical_path.front() == a);
+        REQUIRES(timings.critical_path.back() == f);
+        REQUIRES(timings.critical_path_length >= std::chrono::milliseconds(2));
+        REQUIRES(timings.elapsed >= timings.critical_path_length);
+        REQUIRES(timings.to_string().find("] e at") != std::string::npos);
+
+        const auto failing = graph.emplace([] { throw std::runtime_error("expected"); });
+        graph.precede(f, failing);
+        bool thrown{};
+        try {
+            graph.run(pool);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        REQUIRES(thrown);
+
+        graph.precede(failing, a);
+        thrown = false;
+        try {
+            graph.run(pool);
+        }
+        catch (const std::logic_error&) {
+            thrown = true;
+        }
+        REQUIRES(thrown);
+    }
+
+    // priorities, affinity hints & pinning
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        std::vector<int> order;
+        {
+            // a single worker, held until every task is queued, runs them by lane.
+            atom::utils::thread_pool pool{ 1, mode };
+            std::atomic<bool> started{};
+            std::atomic<bool> release{};
+            pool.submit_detached([&started, &release] {
+                started = true;
+                started.notify_one();
+                release.wait(false);
+            });
+            started.wait(false);
+
+            const auto record = [&order](const int value) { order.emplace_back(value); };
+            pool.submit_detached({ .priority = task_priority::low }, record, -1);
+            for (auto i = 0; i < 40; ++i) {
+                pool.submit_detached({ .priority = task_priority::high }, record, 1);
+            }
+            pool.submit_detached(record, 0);
+            release = true;
+            release.notify_one();
+        }
+
+        REQUIRES(order.size() == 42);
+        REQUIRES(order.front() == 1);
+        // both wait for as many urgent tasks as the starvation limit, not for all of them.
+        REQUIRES(std::ranges::find(order, -1) - order.begin() <= 17);
+        REQUIRES(std::ranges::find(order, 0) - order.begin() <= 17);
+    }
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        atom::utils::thread_pool pool{ 4, mode };
+        std::vector<task_future<std::thread::id>> futures;
+        for (auto i = 0; i < 64; ++i) {
+            futures.emplace_back(
+                pool.submit({ .worker = 2 }, [] { return std::this_thread::get_id(); }));
+        }
+        const auto worker = futures.front().get();
+        REQUIRES(worker != std::this_thread::get_id());
+        REQUIRES(std::ranges::all_of(futures | std::views::drop(1), [worker](auto& future) {
+            return future.get() == worker;
+        }));
+    }
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        // a task hinted at a worker that already left, pushed by a task while the pool stops.
+        std::atomic<bool> ran{};
+        auto pool = std::make_unique<atom::utils::thread_pool>(2, mode);
+        auto* const raw = pool.get();
+        pool->submit({ .worker = 1 }, [] {}).get();
+        std::atomic<bool> started{};
+        std::atomic<bool> release{};
+        pool->submit_detached({ .worker = 0 }, [raw, &ran, &started, &release] {
+            started = true;
+            started.notify_one();
+            release.wait(false);
+            raw->submit_detached({ .worker = 1 }, [&ran] { ran = true; });
+        });
+        started.wait(false);
+
+        std::thread stopper{ [&pool] { pool.reset(); } };
+        // long enough for the idle worker to leave.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        release = true;
+        release.notify_one();
+        stopper.join();
+        REQUIRES(ran.load());
+    }
+#if defined(__linux__)
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        const std::array<uint32_t, 1> cores{ 0 };
+        atom::utils::thread_pool pool{ 2, mode, cores };
+        for (auto i = 0; i < 8; ++i) {
+            REQUIRES(pool.submit([] { return sched_getcpu(); }).get() == 0);
+        }
+    }
+#endif
+
+    // tasks & schedule_on
+    for (const auto mode : { scheduling::shared_queue, scheduling::work_stealing }) {
+        atom::utils::thread_pool pool{ 2, mode };
+
+        std::thread::id resumed_on;
+        REQUIRES(sync_wait(add_twice(pool, resumed_on)) == 6);
+        REQUIRES(resumed_on != std::this_thread::get_id());
+
+        bool thrown{};
+        try {
+            sync_wait(fail_on(pool));
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        REQUIRES(thrown);
+
+        // nested tasks, run inline by symmetric transfer.
+        REQUIRES(sync_wait(count_down(1000)) == 1000);
+
+        std::atomic<bool> started{};
+        auto eager = started_eagerly(pool, started);
+        REQUIRES(started.load());
+        REQUIRES(sync_wait(std::move(eager)) == 42);
+
+        auto lazy = add_on(pool, 2, 2);
+        REQUIRES_FALSE(lazy.done());
+    }
+
+    // thread_safe_coroutine
+    {
+        auto counter = shared_counter(4000);
+        std::vector<int> seen(4000);
+        std::vector<std::thread> threads;
+        for (auto i = 0; i < 4; ++i) {
+            threads.emplace_back([&counter, &seen] {
+                for (auto j = 0; j < 1000; ++j) {
+                    ++seen[counter.get()];
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // every value was handed to exactly one thread.
+        REQUIRES(std::ranges::all_of(seen, [](const int hits) { return hits == 1; }));
+        REQUIRES(counter.is_ready());
+        REQUIRES(counter.get() == -1);
+        REQUIRES(counter.done());
+        REQUIRES(counter.get() == -1);
+
+        auto copy = counter;
+        REQUIRES(copy.done());
+
+        auto failing = failing_counter();
+        REQUIRES(failing.get() == 0);
+        for (auto i = 0; i < 2; ++i) {
+            bool thrown{};
+            try {
+                failing.get();
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            REQUIRES(thrown);
+        }
+        REQUIRES(failing.done());
+    }
+
     // enqueue & latch test
     if (false) {
         const auto task_num = 1000000;